@@ -1,39 +1,34 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
 #include <assert.h>
 
 #include "skiplist.h"
-
-#include <sys/time.h>
+#include "skiplist_pool.h"
+#include "skiplist_unrolled.h"
 
 typedef struct skiplist skiplist;
 
-static const size_t usec_per_sec = 1000000L;
-
-static size_t get_usec_delta(struct timeval *pre, struct timeval *post) {
-    return (usec_per_sec * (post->tv_sec - pre->tv_sec)
-        + (post->tv_usec - pre->tv_usec));
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    int res = clock_gettime(CLOCK_MONOTONIC, &ts);
+    assert(res == 0);
+    (void)res;
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
 }
 
 #define TIME(name)                                                      \
-        struct timeval timer_##name = { 0, 0 };                         \
-        int timer_res_##name = gettimeofday(&timer_##name, NULL);       \
-        (void)timer_res_##name;                                         \
-        assert(0 == timer_res_##name);                                  \
+        uint64_t timer_##name = now_ns();                               \
 
 #define CMP_TIME(label, n1, n2)                                         \
-    do {                                                                \
-        size_t usec_delta = get_usec_delta(&timer_##n1, &timer_##n2);   \
-        double usec_per = usec_delta / (double)lim;                     \
-        double per_second = usec_per_sec / usec_per;                    \
-        printf("%-30s limit %zd %9.3f msec, %6.3f usec per, "           \
-            "%11.3f K ops/sec\n",                                       \
-            label, lim, usec_delta / (double)1000,                      \
-            usec_per, per_second / 1000);                               \
-    } while(0)                                                          \
+        report(label, timer_##n2 - timer_##n1, lim)                     \
 
 #define TDIFF() CMP_TIME(__FUNCTION__, pre, post)
 
@@ -47,6 +42,135 @@ static int intptr_cmp(void *v1, void *v2) {
     return a < b ? -1 : a > b ? 1 : 0;
 }
 
+static int str_cmp(void *v1, void *v2) {
+    return strcmp((const char *)v1, (const char *)v2);
+}
+
+const char *bench_words[] = {
+#include "test_words.h"
+};
+
+/* xorshift64*, for key generation. */
+static uint64_t rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * UINT64_C(2685821657736338717);
+}
+
+/* Bounded Zipfian generator (YCSB-style): a small hot set of keys
+ * receives most of the probes. */
+struct zipf {
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+};
+
+static double zeta(uint64_t n, double theta) {
+    double sum = 0.0;
+    for (uint64_t i = 1; i <= n; i++) {
+        sum += 1.0 / pow((double)i, theta);
+    }
+    return sum;
+}
+
+static void zipf_init(struct zipf *z, uint64_t n, double theta) {
+    z->n = n;
+    z->theta = theta;
+    z->zetan = zeta(n, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) /
+        (1.0 - zeta(2, theta) / z->zetan);
+}
+
+static uint64_t zipf_next(struct zipf *z, uint64_t *rng) {
+    double u = (double)(rng_next(rng) >> 11) / 9007199254740992.0;
+    double uz = u * z->zetan;
+    if (uz < 1.0) { return 0; }
+    if (uz < 1.0 + pow(0.5, z->theta)) { return 1; }
+    return (uint64_t)((double)z->n *
+        pow(z->eta * u - z->eta + 1.0, z->alpha));
+}
+
+/***************************************/
+/* Reporting, CSV output and baseline  */
+/***************************************/
+
+/* Rows loaded from a stored --baseline CSV. */
+struct baseline_row {
+    char op[48];
+    char dist[16];
+    long size;
+    double ops_sec;
+};
+
+static const char *cur_dist = "seq";    /* distribution for CSV rows */
+static FILE *csv_out = NULL;
+static struct baseline_row *baseline = NULL;
+static size_t baseline_count = 0;
+static double tolerance_pct = 10.0;
+static size_t regressions = 0;
+
+static const struct baseline_row *baseline_find(const char *op,
+        const char *dist, long size) {
+    for (size_t i = 0; i < baseline_count; i++) {
+        const struct baseline_row *r = &baseline[i];
+        if (r->size == size && 0 == strcmp(r->op, op)
+            && 0 == strcmp(r->dist, dist)) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/* Print the human-readable line for a benchmark, append a CSV row
+ * when --csv is set, and flag the result as a regression when it is
+ * more than --tolerance percent slower than the stored baseline. */
+static void report(const char *label, uint64_t ns_delta, long n) {
+    double ns_per = ns_delta / (double)n;
+    double per_second = 1e9 / ns_per;
+    printf("%-30s limit %zd %9.3f msec, %6.3f usec per, "
+        "%11.3f K ops/sec\n",
+        label, n, ns_delta / (double)1e6,
+        ns_per / 1000, per_second / 1000);
+    if (csv_out) {
+        fprintf(csv_out, "%s,%s,%ld,%.1f,%.0f\n",
+            label, cur_dist, n, ns_per, per_second);
+    }
+    const struct baseline_row *base = baseline_find(label, cur_dist, n);
+    if (base && per_second < base->ops_sec * (1.0 - tolerance_pct / 100)) {
+        printf("  REGRESSION: %s/%s/%ld: %.0f ops/sec, "
+            "baseline %.0f (-%.1f%%)\n",
+            label, cur_dist, n, per_second, base->ops_sec,
+            100 * (1.0 - per_second / base->ops_sec));
+        regressions++;
+    }
+}
+
+static bool baseline_load(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) { return false; }
+    size_t ceil = 64;
+    baseline = malloc(ceil * sizeof(*baseline));
+    assert(baseline);
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (baseline_count == ceil) {
+            ceil *= 2;
+            baseline = realloc(baseline, ceil * sizeof(*baseline));
+            assert(baseline);
+        }
+        struct baseline_row *r = &baseline[baseline_count];
+        if (4 == sscanf(line, "%47[^,],%15[^,],%ld,%*f,%lf",
+                r->op, r->dist, &r->size, &r->ops_sec)) {
+            baseline_count++;
+        }                       /* skip header and malformed lines */
+    }
+    fclose(f);
+    return true;
+}
+
 /* Measure insertions. */
 static void ins(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
@@ -61,6 +185,173 @@ static void ins(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/* Measure insertions with a per-list seeded PRNG, which draws node
+ * heights without going through random(). Compare against ins(). */
+static void ins_local_rng(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+    skiplist_set_seed_local(sl, 42);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* Measure sorted-order insertions through a search finger, which
+ * resumes each search from the previous key instead of restarting
+ * from the head. Compare against ins(). */
+static void ins_finger(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+    struct skiplist_finger *f = skiplist_finger_new(sl);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add_at(f, (void *) i, (void *) i);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_finger_free(f);
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* Measure insertions in a scattered key order, the baseline for
+ * ins_batch below. */
+static void ins_scattered(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % lim;
+        skiplist_add(sl, (void *) k, (void *) k);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* Measure scattered insertions submitted in batches of 256, which
+ * are sorted internally and applied in one walk each. */
+static void ins_batch(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+    enum { BATCH = 256 };
+    void *keys[BATCH];
+
+    TIME(pre);
+    for (intptr_t base = 0; base < lim; base += BATCH) {
+        intptr_t n = lim - base < BATCH ? lim - base : BATCH;
+        for (intptr_t i = 0; i < n; i++) {
+            keys[i] = (void *) (((base + i) * largeish_prime) % lim);
+        }
+        skiplist_add_batch(sl, keys, keys, n);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* Measure bulk-loading pre-sorted input, the O(n) counterpart
+ * to the per-key searches measured in ins(). */
+static void load_sorted(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    void **keys = malloc(lim * sizeof(void *));
+    assert(keys);
+    for (intptr_t i=0; i < lim; i++) { keys[i] = (void *) i; }
+
+    TIME(pre);
+    skiplist_load_sorted(sl, keys, keys, lim);
+    TIME(post);
+
+    assert(skiplist_count(sl) == (size_t)lim);
+    TDIFF();
+    free(keys);
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* Measure merging two interleaved lists of lim/2 pairs each by
+ * node-stealing. */
+static void merge(void) {
+    skiplist *a = skiplist_new(intptr_cmp, NULL, NULL);
+    skiplist *b = skiplist_new(intptr_cmp, NULL, NULL);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(i % 2 ? b : a, (void *) i, (void *) i);
+    }
+
+    TIME(pre);
+    skiplist_merge(a, b);
+    TIME(post);
+
+    assert(skiplist_count(a) == (size_t)lim);
+    TDIFF();
+    skiplist_free(a, NULL, NULL);
+    skiplist_free(b, NULL, NULL);
+}
+
+/* Measure insertions through a pooled allocator. */
+static void ins_pool(void) {
+    struct skiplist_pool *p = skiplist_pool_new(0, 0);
+    skiplist *sl = skiplist_new(intptr_cmp, skiplist_pool_cb, p);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+    skiplist_pool_free(p);
+}
+
+/* Measure insert/delete churn through a pooled allocator, where
+ * freed nodes are recycled without touching malloc. */
+static void churn_pool(void) {
+    struct skiplist_pool *p = skiplist_pool_new(0, 0);
+    skiplist *sl = skiplist_new(intptr_cmp, skiplist_pool_cb, p);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % lim;
+        skiplist_delete(sl, (void *) k, NULL);
+        skiplist_add(sl, (void *) k, (void *) k);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+    skiplist_pool_free(p);
+}
+
+/* The same churn workload with the default malloc/free allocator,
+ * for comparison against churn_pool. */
+static void churn_malloc(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % lim;
+        skiplist_delete(sl, (void *) k, NULL);
+        skiplist_add(sl, (void *) k, (void *) k);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
 /* Measure getting existing values (successful lookup). */
 static void get(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
@@ -83,6 +374,37 @@ static void get(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/* Measure interleaved batch lookups against the same scattered keys
+ * as get: skiplist_get_many hides the cache misses of one search
+ * behind the comparisons of the others. */
+static void get_many(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+    #define GM_BATCH 256
+    void *keys[GM_BATCH];
+    void *vals[GM_BATCH];
+
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i += GM_BATCH) {
+        intptr_t n = lim - i < GM_BATCH ? lim - i : GM_BATCH;
+        for (intptr_t j=0; j < n; j++) {
+            keys[j] = (void *) (((i + j) * largeish_prime) % lim);
+        }
+        size_t found = skiplist_get_many(sl, keys, vals, n);
+        assert(found == (size_t)n);
+        (void)found;
+        for (intptr_t j=0; j < n; j++) { assert(vals[j] == keys[j]); }
+    }
+    TIME(post);
+    #undef GM_BATCH
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
 /* Measure getting _nonexistent_ values (lookup failure). */
 static void get_nonexistent(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
@@ -199,6 +521,46 @@ static void set_and_get(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/* "Increment the value for key K" as two searches (get + set)... */
+static void counter_get_set(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % (lim / 4);
+        intptr_t v = 0;
+        (void)skiplist_get(sl, (void *) k, (void **)&v);
+        skiplist_set(sl, (void *) k, (void *)(v + 1), NULL);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
+static bool bump_cb(void *key, void **value, bool present, void *udata) {
+    (void)key;
+    (void)present;
+    (void)udata;
+    *value = (void *) ((intptr_t) *value + 1);
+    return true;
+}
+
+/* ...against one search through skiplist_update. */
+static void counter_update(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % (lim / 4);
+        skiplist_update(sl, (void *) k, bump_cb, NULL);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
 static void delete(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
 
@@ -262,6 +624,30 @@ static void delete_nonexistent(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/* Measure a TTL-style purge: deleting 10% spans of the keyspace with
+ * one range-delete each, vs. the per-key searches measured in
+ * delete(). */
+static void delete_range(void) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+
+    TIME(pre);
+    intptr_t span = lim / 10;
+    if (span == 0) { span = 1; }
+    for (intptr_t lo = 0; lo < lim; lo += span) {
+        skiplist_delete_range(sl, (void *) lo,
+            (void *) (lo + span - 1), NULL, NULL);
+    }
+    TIME(post);
+
+    assert(skiplist_count(sl) == 0);
+    TDIFF();
+    skiplist_free(sl, NULL, NULL);
+}
+
 static void ins_and_delete_nonexistent(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
 
@@ -463,6 +849,59 @@ static void ins_and_sum(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/* The ins/get/sum workloads against the unrolled (block-node)
+ * variant, for comparing against ins(), get(), and sum(). */
+static void ins_unrolled(void) {
+    struct skiplist_u *sl = skiplist_u_new(intptr_cmp, NULL, NULL);
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_u_add(sl, (void *) i, (void *) i);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_u_free(sl, NULL, NULL);
+}
+
+static void get_unrolled(void) {
+    struct skiplist_u *sl = skiplist_u_new(intptr_cmp, NULL, NULL);
+
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_u_add(sl, (void *) i, (void *) i);
+    }
+
+    TIME(pre);
+    for (intptr_t i=0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % lim;
+        intptr_t v = 0;
+        skiplist_u_get(sl, (void *) k, (void **)&v);
+        if (0) { printf("%lu %lu\n", k, v); }
+        assert(v == k);
+    }
+    TIME(post);
+
+    TDIFF();
+    skiplist_u_free(sl, NULL, NULL);
+}
+
+static void sum_unrolled(void) {
+    struct skiplist_u *sl = skiplist_u_new(intptr_cmp, NULL, NULL);
+
+    for (intptr_t i=0; i < lim; i++) {
+        skiplist_u_add(sl, (void *) i, (void *) i);
+    }
+
+    TIME(pre);
+    intptr_t total = 0;
+    skiplist_u_iter(sl, sum_cb, &total);
+    if (0) { fprintf(stderr, "sum: %lu\n", total); }
+    TIME(post);
+
+    TDIFF();
+    skiplist_u_free(sl, NULL, NULL);
+}
+
 static void ins_and_sum_partway(void) {
     skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
 
@@ -480,28 +919,186 @@ static void ins_and_sum_partway(void) {
     skiplist_free(sl, NULL, NULL);
 }
 
+/***************************/
+/* Size/distribution sweep */
+/***************************/
+
+static const char *dist_filter = NULL;
+
+/* One sweep cell: build n keys for the given distribution, then time
+ * inserting them all and probing them all. Each measured loop is
+ * preceded by an untimed warmup pass over n/10 operations, so the
+ * allocator and page cache are primed before the clock starts. */
+static void sweep_cell(const char *dist, long n) {
+    cur_dist = dist;
+    bool words = (0 == strcmp(dist, "words"));
+    bool is_zipf = (0 == strcmp(dist, "zipf"));
+    skiplist *sl = skiplist_new(words ? str_cmp : intptr_cmp, NULL, NULL);
+    assert(sl);
+    void **keys = malloc(n * sizeof(void *));
+    assert(keys);
+    char *arena = NULL;
+    uint64_t rng = UINT64_C(0x9e3779b97f4a7c15) ^ (uint64_t)n;
+    struct zipf z = { 0, 0.0, 0.0, 0.0, 0.0 };
+
+    if (words) {
+        /* Wordlist entries, with a numeric suffix for uniqueness
+         * once the list size exceeds the wordlist. */
+        size_t n_words = 0;
+        while (bench_words[n_words]) { n_words++; }
+        arena = malloc(n * 32);
+        assert(arena);
+        for (long i = 0; i < n; i++) {
+            keys[i] = arena + 32 * i;
+            snprintf(arena + 32 * i, 32, "%s-%lx",
+                bench_words[i % n_words], (unsigned long)i);
+        }
+    } else if (0 == strcmp(dist, "rand")) {
+        for (long i = 0; i < n; i++) {
+            keys[i] = (void *)(intptr_t)rng_next(&rng);
+        }
+    } else {                    /* seq and zipf: dense key space */
+        for (long i = 0; i < n; i++) {
+            keys[i] = (void *)(intptr_t)i;
+        }
+    }
+    if (is_zipf) { zipf_init(&z, (uint64_t)n, 0.99); }
+
+    {                           /* insertion warmup, on a scratch list */
+        skiplist *w = skiplist_new(words ? str_cmp : intptr_cmp,
+            NULL, NULL);
+        assert(w);
+        for (long i = 0; i < n / 10; i++) {
+            skiplist_add(w, keys[i], keys[i]);
+        }
+        skiplist_free(w, NULL, NULL);
+    }
+
+    char label[48];
+    snprintf(label, sizeof(label), "sweep_ins[%s]", dist);
+    uint64_t pre = now_ns();
+    for (long i = 0; i < n; i++) {
+        skiplist_add(sl, keys[i], keys[i]);
+    }
+    report(label, now_ns() - pre, n);
+
+    for (long i = 0; i < n / 10; i++) {   /* probe warmup */
+        void *v = NULL;
+        skiplist_get(sl, keys[(i * largeish_prime) % n], &v);
+    }
+
+    snprintf(label, sizeof(label), "sweep_get[%s]", dist);
+    pre = now_ns();
+    for (long i = 0; i < n; i++) {
+        void *k = is_zipf
+          ? (void *)(intptr_t)zipf_next(&z, &rng)
+          : keys[(i * largeish_prime) % n];
+        void *v = NULL;
+        skiplist_get(sl, k, &v);
+    }
+    report(label, now_ns() - pre, n);
+
+    skiplist_free(sl, NULL, NULL);
+    free(arena);
+    free(keys);
+}
+
+/* Decade steps from 10^4 up to max_size, for every distribution (or
+ * just --dist). Large steps expose where the working set falls out
+ * of successive cache levels; pass a MAX_SIZE of 10^8 on a machine
+ * with memory to spare. */
+static void sweep(long max_size) {
+    static const char *dists[] = { "seq", "rand", "zipf", "words" };
+    for (long n = 10000; n <= max_size; n *= 10) {
+        for (size_t d = 0; d < sizeof(dists)/sizeof(dists[0]); d++) {
+            if (dist_filter && 0 != strcmp(dist_filter, dists[d])) {
+                continue;
+            }
+            sweep_cell(dists[d], n);
+        }
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr,
+        "Usage: bench [LIMIT]\n"
+        "       bench --sweep [MAX_SIZE] [--dist seq|rand|zipf|words]\n"
+        "Common options:\n"
+        "       --csv FILE        also write results as CSV\n"
+        "       --baseline FILE   compare against a stored CSV\n"
+        "       --tolerance PCT   regression threshold (default 10)\n");
+    exit(1);
+}
+
 int main(int argc, char **argv) {
-    if (argc > 1) {
-        lim = atol(argv[1]);
-        if (lim <= 1) {
-            fprintf(stderr, "Bad limit.\nUsage: bench [LIMIT]\n");
-            exit(1);
+    bool sweep_mode = false;
+    long size_arg = 0;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--sweep")) {
+            sweep_mode = true;
+        } else if (0 == strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csv_out = fopen(argv[++i], "w");
+            if (csv_out == NULL) {
+                fprintf(stderr, "Failed to open '%s'.\n", argv[i]);
+                exit(1);
+            }
+            fprintf(csv_out, "op,dist,size,ns_per_op,ops_per_sec\n");
+        } else if (0 == strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            if (!baseline_load(argv[++i])) {
+                fprintf(stderr, "Failed to open '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (0 == strcmp(argv[i], "--tolerance") && i + 1 < argc) {
+            tolerance_pct = atof(argv[++i]);
+        } else if (0 == strcmp(argv[i], "--dist") && i + 1 < argc) {
+            dist_filter = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            size_arg = atol(argv[i]);
+            if (size_arg <= 1) {
+                fprintf(stderr, "Bad limit.\n");
+                usage();
+            }
         }
-    } else {
-        lim = DEF_LIM;
     }
 
+    if (sweep_mode) {
+        sweep(size_arg ? size_arg : 1000000);
+        if (csv_out) { fclose(csv_out); }
+        if (regressions > 0) {
+            printf("----\n%zd regression(s) against baseline\n",
+                regressions);
+            return 1;
+        }
+        return 0;
+    }
+    lim = size_arg ? size_arg : DEF_LIM;
+
     TIME(pre);
     ins();
+    ins_pool();
+    ins_local_rng();
+    ins_finger();
+    ins_scattered();
+    ins_batch();
+    load_sorted();
+    merge();
+    churn_malloc();
+    churn_pool();
     get();
+    get_many();
     get_nonexistent();
     set();
     delete();
     delete_nonexistent();
+    delete_range();
     ins_and_get();
     ins_and_get_nonexistent();
     ins_and_count();
     set_and_get();
+    counter_get_set();
+    counter_update();
     ins_and_delete();
     ins_and_delete_nonexistent();
     pop_first();
@@ -514,10 +1111,18 @@ int main(int argc, char **argv) {
     sum();
     ins_and_sum();
     ins_and_sum_partway();
+    ins_unrolled();
+    get_unrolled();
+    sum_unrolled();
 
     TIME(post);
-    double usec_total = (double)get_usec_delta(&timer_pre, &timer_post);
-    printf("----\n%-30s %.3f sec\n", "total", usec_total / usec_per_sec);
+    printf("----\n%-30s %.3f sec\n", "total",
+        (timer_post - timer_pre) / (double)1e9);
 
+    if (csv_out) { fclose(csv_out); }
+    if (regressions > 0) {
+        printf("----\n%zd regression(s) against baseline\n", regressions);
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,390 @@
+/* Multi-threaded contention benchmarks. Where bench.c measures
+ * single-threaded throughput, this harness runs pthread-based
+ * scenarios -- N readers vs. one writer, independent writers on
+ * per-thread (sharded) lists, and a mixed 95/5 read/write workload
+ * with Zipfian keys on a lock-free list -- and reports p50/p99/p999
+ * latencies from per-thread histograms, not just the mean. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "skiplist.h"
+
+typedef struct skiplist skiplist;
+
+#define DEF_LIM 100000
+#define MAX_THREADS 16
+
+static const int largeish_prime = 7919;
+static long lim = DEF_LIM;
+
+static int intptr_cmp(void *v1, void *v2) {
+    intptr_t a = (intptr_t) v1, b = (intptr_t) v2;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    int res = clock_gettime(CLOCK_MONOTONIC, &ts);
+    assert(res == 0);
+    (void)res;
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift64*, one per thread, no locks. */
+static uint64_t rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * UINT64_C(2685821657736338717);
+}
+
+/* Latency histogram: log2 buckets with 3 sub-bucket bits, so values
+ * are accurate to within ~12%. Cheap enough to record every op. */
+#define HIST_SUB_BITS 3
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) << HIST_SUB_BITS)
+struct hist {
+    uint64_t total;
+    uint64_t counts[HIST_BUCKETS];
+};
+
+static void hist_record(struct hist *h, uint64_t ns) {
+    size_t idx;
+    if (ns < (1u << HIST_SUB_BITS)) {
+        idx = ns;
+    } else {
+        int exp = 63 - __builtin_clzll(ns);
+        size_t sub = (ns >> (exp - HIST_SUB_BITS)) &
+            ((1u << HIST_SUB_BITS) - 1);
+        idx = ((size_t)(exp - HIST_SUB_BITS + 1) << HIST_SUB_BITS) | sub;
+    }
+    if (idx >= HIST_BUCKETS) { idx = HIST_BUCKETS - 1; }
+    h->counts[idx]++;
+    h->total++;
+}
+
+static uint64_t hist_bucket_value(size_t idx) {
+    if (idx < (1u << HIST_SUB_BITS)) { return idx; }
+    int exp = (int)(idx >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+    uint64_t sub = idx & ((1u << HIST_SUB_BITS) - 1);
+    return (UINT64_C(1) << exp) | (sub << (exp - HIST_SUB_BITS));
+}
+
+static void hist_merge(struct hist *into, const struct hist *from) {
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+}
+
+static uint64_t hist_percentile(const struct hist *h, double q) {
+    uint64_t target = (uint64_t)(q * (double)h->total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > target) { return hist_bucket_value(i); }
+    }
+    return hist_bucket_value(HIST_BUCKETS - 1);
+}
+
+static void report(const char *label, int threads, uint64_t ops,
+        uint64_t wall_ns, const struct hist *h) {
+    double mops = (double)ops * 1000.0 / (double)wall_ns;
+    printf("%-24s threads %2d ops %9llu %8.3f Mops/sec "
+        "p50 %6llu p99 %6llu p999 %7llu ns\n",
+        label, threads, (unsigned long long)ops, mops,
+        (unsigned long long)hist_percentile(h, 0.50),
+        (unsigned long long)hist_percentile(h, 0.99),
+        (unsigned long long)hist_percentile(h, 0.999));
+}
+
+/* Bounded Zipfian generator (YCSB-style), theta 0.99: a small hot
+ * set receives most of the probes. */
+struct zipf {
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+};
+
+static double zeta(uint64_t n, double theta) {
+    double sum = 0.0;
+    for (uint64_t i = 1; i <= n; i++) {
+        sum += 1.0 / pow((double)i, theta);
+    }
+    return sum;
+}
+
+static void zipf_init(struct zipf *z, uint64_t n, double theta) {
+    z->n = n;
+    z->theta = theta;
+    z->zetan = zeta(n, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) /
+        (1.0 - zeta(2, theta) / z->zetan);
+}
+
+static uint64_t zipf_next(struct zipf *z, uint64_t *rng) {
+    double u = (double)(rng_next(rng) >> 11) / 9007199254740992.0;
+    double uz = u * z->zetan;
+    if (uz < 1.0) { return 0; }
+    if (uz < 1.0 + pow(0.5, z->theta)) { return 1; }
+    return (uint64_t)((double)z->n *
+        pow(z->eta * u - z->eta + 1.0, z->alpha));
+}
+
+/* ---- N readers vs. one writer ---- */
+
+struct rw_env {
+    skiplist *sl;
+    uint64_t seed;
+    long ops;
+    bool writer;
+    volatile bool *stop;
+    struct hist hist;
+    uint64_t done;
+};
+
+static void *rw_body(void *arg) {
+    struct rw_env *env = (struct rw_env *)arg;
+    skiplist *sl = env->sl;
+    uint64_t rng = env->seed;
+
+    if (env->writer) {
+        /* Churn until every reader is done; not measured. */
+        while (!*env->stop) {
+            intptr_t k = (intptr_t)(rng_next(&rng) % (uint64_t)lim);
+            void *v = NULL;
+            if (skiplist_delete(sl, (void *) k, &v)) {
+                skiplist_add(sl, (void *) k, v);
+            }
+            if ((rng & 0x3ff) == 0) { skiplist_reclaim(sl); }
+        }
+        return NULL;
+    }
+
+    for (long i = 0; i < env->ops; i++) {
+        intptr_t k = (intptr_t)(rng_next(&rng) % (uint64_t)lim);
+        uint64_t pre = now_ns();
+        unsigned e = skiplist_epoch_enter(sl);
+        skiplist_get(sl, (void *) k, NULL);
+        skiplist_epoch_leave(sl, e);
+        hist_record(&env->hist, now_ns() - pre);
+        env->done++;
+    }
+    return NULL;
+}
+
+static void readers_vs_writer(int nreaders) {
+    skiplist *sl = skiplist_new(intptr_cmp, NULL, NULL);
+    skiplist_set_seed_local(sl, 42);
+    for (intptr_t i = 0; i < lim; i++) {
+        skiplist_add(sl, (void *) i, (void *) i);
+    }
+
+    volatile bool stop = false;
+    struct rw_env envs[MAX_THREADS + 1];
+    pthread_t tids[MAX_THREADS + 1];
+    memset(envs, 0, sizeof(envs));
+    for (int t = 0; t <= nreaders; t++) {
+        envs[t] = (struct rw_env) {
+            .sl = sl,
+            .seed = 1 + (uint64_t)t,
+            .ops = lim,
+            .writer = (t == nreaders),
+            .stop = &stop,
+        };
+    }
+
+    uint64_t pre = now_ns();
+    for (int t = 0; t <= nreaders; t++) {
+        int res = pthread_create(&tids[t], NULL, rw_body, &envs[t]);
+        assert(res == 0);
+        (void)res;
+    }
+    for (int t = 0; t < nreaders; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    stop = true;
+    pthread_join(tids[nreaders], NULL);
+    uint64_t wall = now_ns() - pre;
+
+    struct hist total;
+    memset(&total, 0, sizeof(total));
+    uint64_t ops = 0;
+    for (int t = 0; t < nreaders; t++) {
+        hist_merge(&total, &envs[t].hist);
+        ops += envs[t].done;
+    }
+    report("readers_vs_writer", nreaders, ops, wall, &total);
+    while (skiplist_reclaim(sl) > 0) {}
+    skiplist_free(sl, NULL, NULL);
+}
+
+/* ---- N writers, one private (sharded) list each ---- */
+
+struct shard_env {
+    skiplist *sl;
+    uint64_t seed;
+    struct hist hist;
+    uint64_t done;
+};
+
+static void *shard_body(void *arg) {
+    struct shard_env *env = (struct shard_env *)arg;
+    for (long i = 0; i < lim; i++) {
+        intptr_t k = (i * largeish_prime) % lim;
+        uint64_t pre = now_ns();
+        skiplist_add(env->sl, (void *) k, (void *) k);
+        hist_record(&env->hist, now_ns() - pre);
+        env->done++;
+    }
+    return NULL;
+}
+
+static void sharded_writers(int nwriters) {
+    struct shard_env envs[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+    memset(envs, 0, sizeof(envs));
+    for (int t = 0; t < nwriters; t++) {
+        envs[t].sl = skiplist_new(intptr_cmp, NULL, NULL);
+        envs[t].seed = 1 + (uint64_t)t;
+        /* Per-list PRNGs: height generation doesn't serialize the
+         * threads on random()'s lock. */
+        skiplist_set_seed_local(envs[t].sl, envs[t].seed);
+    }
+
+    uint64_t pre = now_ns();
+    for (int t = 0; t < nwriters; t++) {
+        int res = pthread_create(&tids[t], NULL, shard_body, &envs[t]);
+        assert(res == 0);
+        (void)res;
+    }
+    for (int t = 0; t < nwriters; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    uint64_t wall = now_ns() - pre;
+
+    struct hist total;
+    memset(&total, 0, sizeof(total));
+    uint64_t ops = 0;
+    for (int t = 0; t < nwriters; t++) {
+        hist_merge(&total, &envs[t].hist);
+        ops += envs[t].done;
+        assert(skiplist_count(envs[t].sl) == (size_t)lim);
+        skiplist_free(envs[t].sl, NULL, NULL);
+    }
+    report("sharded_writers", nwriters, ops, wall, &total);
+}
+
+/* ---- mixed 95/5 read/write, Zipfian keys, lock-free list ---- */
+
+struct mixed_env {
+    skiplist *sl;
+    struct zipf *z;
+    uint64_t seed;
+    long ops;
+    struct hist hist;
+    uint64_t done;
+};
+
+static void *mixed_body(void *arg) {
+    struct mixed_env *env = (struct mixed_env *)arg;
+    skiplist *sl = env->sl;
+    uint64_t rng = env->seed;
+
+    for (long i = 0; i < env->ops; i++) {
+        intptr_t k = (intptr_t)zipf_next(env->z, &rng);
+        bool write = (rng_next(&rng) % 100) < 5;
+        uint64_t pre = now_ns();
+        unsigned e = skiplist_epoch_enter(sl);
+        if (!write) {
+            skiplist_concurrent_get(sl, (void *) k, NULL);
+        } else if (rng & 1) {
+            skiplist_concurrent_delete(sl, (void *) k, NULL);
+        } else {
+            skiplist_concurrent_add(sl, (void *) k, (void *) k);
+        }
+        skiplist_epoch_leave(sl, e);
+        hist_record(&env->hist, now_ns() - pre);
+        env->done++;
+    }
+    return NULL;
+}
+
+static void mixed_zipf(int nthreads) {
+    skiplist *sl = skiplist_new_concurrent(intptr_cmp, NULL, NULL);
+    for (intptr_t i = 0; i < lim; i++) {
+        skiplist_concurrent_add(sl, (void *) i, (void *) i);
+    }
+    struct zipf z;
+    zipf_init(&z, (uint64_t)lim, 0.99);
+
+    struct mixed_env envs[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+    memset(envs, 0, sizeof(envs));
+    for (int t = 0; t < nthreads; t++) {
+        envs[t] = (struct mixed_env) {
+            .sl = sl,
+            .z = &z,
+            .seed = 1 + (uint64_t)t,
+            .ops = lim,
+        };
+    }
+
+    uint64_t pre = now_ns();
+    for (int t = 0; t < nthreads; t++) {
+        int res = pthread_create(&tids[t], NULL, mixed_body, &envs[t]);
+        assert(res == 0);
+        (void)res;
+    }
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    uint64_t wall = now_ns() - pre;
+
+    struct hist total;
+    memset(&total, 0, sizeof(total));
+    uint64_t ops = 0;
+    for (int t = 0; t < nthreads; t++) {
+        hist_merge(&total, &envs[t].hist);
+        ops += envs[t].done;
+    }
+    report("mixed_95_5_zipf", nthreads, ops, wall, &total);
+    while (skiplist_reclaim(sl) > 0) {}
+    skiplist_free(sl, NULL, NULL);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        lim = atol(argv[1]);
+        if (lim <= 1) {
+            fprintf(stderr, "Bad limit.\nUsage: bench_mt [LIMIT]\n");
+            exit(1);
+        }
+    } else {
+        lim = DEF_LIM;
+    }
+
+    static const int counts[] = { 1, 2, 4, 8 };
+    for (size_t i = 0; i < sizeof(counts)/sizeof(counts[0]); i++) {
+        readers_vs_writer(counts[i]);
+    }
+    for (size_t i = 0; i < sizeof(counts)/sizeof(counts[0]); i++) {
+        sharded_writers(counts[i]);
+    }
+    for (size_t i = 0; i < sizeof(counts)/sizeof(counts[0]); i++) {
+        mixed_zipf(counts[i]);
+    }
+    return 0;
+}
@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <assert.h>
 
@@ -23,32 +24,162 @@
 #include "skiplist.h"
 #include "skiplist_macros_internal.h"
 
+/* A retired node awaiting reclamation. The node's own fields must
+ * stay intact while readers may still be traversing it, so limbo
+ * lists are linked through these small wrappers. */
+struct skiplist_limbo_node {
+    struct skiplist_node *n;
+    struct skiplist_limbo_node *next;
+};
+
 struct skiplist {
     size_t count;
     struct skiplist_node *head;
     skiplist_cmp_cb *cmp;
     skiplist_alloc_cb *alloc;
     void *alloc_udata;
+
+    /* Epoch-based reclamation state (see skiplist_epoch_enter in
+     * skiplist.h). Once any reader has entered an epoch, DEFERRED is
+     * set and removed nodes go on the limbo list for the current
+     * epoch instead of being freed; skiplist_reclaim frees the limbo
+     * list that no reader can still be traversing. */
+    bool deferred;
+    unsigned epoch;
+    size_t epoch_readers[2];
+    struct skiplist_limbo_node *limbo[2];
+
+    /* Created with skiplist_new_concurrent, for the lock-free
+     * multi-writer operations. */
+    bool concurrent;
+
+    /* Per-list PRNG state for height generation; 0 means unseeded,
+     * falling back to random() (see skiplist_set_seed_local). */
+    uint64_t rng;
+
+    /* Cap generated heights near log2(count) + 1
+     * (see skiplist_set_adaptive_height). */
+    bool adaptive;
+
+    /* Optional pair destructor, used by the destructive operations
+     * when their callback argument is NULL
+     * (see skiplist_set_destructor). */
+    skiplist_free_cb *dtor;
+    void *dtor_udata;
+
+#if SKIPLIST_FINGERPRINT
+    /* Optional key fingerprint callback
+     * (see skiplist_set_prefix_cb). */
+    skiplist_prefix_cb *prefix;
+#endif
+
+#if SKIPLIST_STATS
+    /* Statistics counters (see skiplist_stats). */
+    size_t stat_bytes;          /* live node + list struct bytes */
+    size_t stat_head_grows;
+    uint64_t stat_searches;
+    uint64_t stat_cmps;
+#endif
 };
 
 struct skiplist_node {
     int h;                  /* node height */
+#if SKIPLIST_FINGERPRINT
+    uint64_t fp;            /* key fingerprint, computed on insert */
+#endif
+#if SKIPLIST_INLINE_KEY_SIZE > 0
+    void *v;                /* value */
+    /* Key bytes, copied into the node on insert so comparisons
+     * don't chase a pointer into a cold cache line. */
+    uint8_t k[SKIPLIST_INLINE_KEY_SIZE];
+#else
     void *k;                /* key */
     void *v;                /* value */
+#endif
+
+#if SKIPLIST_BACK_POINTERS
+    /* Level-0 predecessor; NULL on the first node. Heads are never
+     * referenced, since grow_head can swap them out. */
+    struct skiplist_node *prev;
+#endif
 
     /* Forward pointers.
      * allocated with (h)*sizeof(N*) extra bytes. */
     struct skiplist_node *next[];
 };
 
+/* The key of node N, as passed to the cmp callback. */
+#if SKIPLIST_INLINE_KEY_SIZE > 0
+#define NODE_KEY(n) ((void *)(n)->k)
+#else
+#define NODE_KEY(n) ((n)->k)
+#endif
+
 /* Sentinel. */
-static struct skiplist_node SENTINEL = { 0, NULL, NULL };
+static struct skiplist_node SENTINEL = { .h = 0 };
 #define IS_SENTINEL(n) (n == &SENTINEL)
 
+#if SKIPLIST_WIDTHS
+/* The span widths live after the forward pointers, in the same
+ * allocation: NODE_WIDTHS(n)[i] is the number of level-0 links
+ * covered by n->next[i] -- one per node passed, plus one for the
+ * final step. The widths along any level sum to count + 1. */
+#define NODE_WIDTHS(n) ((size_t *)(void *)&(n)->next[(n)->h])
+#endif
+
+#if SKIPLIST_BACK_POINTERS
+/* Point N back at PREV on the bottom level. A head becomes NULL:
+ * heads can be swapped out (grow_head, merge), so no back-pointer
+ * may reference one. The shared sentinel is left alone. */
+static void back_link(struct skiplist_node *n,
+        struct skiplist_node *prev, struct skiplist_node *head) {
+    if (IS_SENTINEL(n)) { return; }
+    n->prev = (prev == head) ? NULL : prev;
+}
+#endif
+
+/* Compare two keys: an indirect call through the cmp callback,
+ * unless an inlined comparison was provided at compile time. */
+#ifdef SKIPLIST_CMP_INLINE
+#define SL_CMP(sl, a, b) (SKIPLIST_CMP_INLINE((a), (b)))
+#else
+#define SL_CMP(sl, a, b) ((sl)->cmp((a), (b)))
+#endif
+
+/* The fingerprint for a probe key, and a node-vs-probe comparison
+ * that tries the stored fingerprints first. KFP must be KEY's
+ * fingerprint. Since fingerprints are monotonic in key order (see
+ * skiplist_set_prefix_cb), unequal fingerprints decide the
+ * comparison with an integer compare on data already in the node's
+ * cache line; the full callback only runs on fingerprint ties. */
+#if SKIPLIST_FINGERPRINT
+#define KEY_FP(sl, key) ((sl)->prefix ? (sl)->prefix(key) : 0)
+#define NODE_CMP(sl, n, kfp, key)                                       \
+    ((sl)->prefix == NULL ? SL_CMP(sl, NODE_KEY(n), key)                \
+        : (n)->fp < (kfp) ? -1                                          \
+        : (n)->fp > (kfp) ? 1                                           \
+        : SL_CMP(sl, NODE_KEY(n), key))
+#else
+#define KEY_FP(sl, key) 0
+#define NODE_CMP(sl, n, kfp, key)                                       \
+    ((void)(kfp), SL_CMP(sl, NODE_KEY(n), key))
+#endif
+
+/* Bump a statistics counter; compiles away entirely when
+ * SKIPLIST_STATS is off. Usable as an expression. */
+#if SKIPLIST_STATS
+#define STAT_ADD(sl, field, n) ((sl)->field += (n))
+#else
+#define STAT_ADD(sl, field, n) ((void)0)
+#endif
+
 static struct skiplist_node *
 node_alloc(struct skiplist *sl, uint8_t height, void *key, void *value);
 static void *def_alloc(void *p,
     size_t osize, size_t nsize, void *udata);
+static struct skiplist_node *insert_node(struct skiplist *sl,
+    void *key, void *value, int cur_height,
+    struct skiplist_node **prevs, size_t *ranks);
 
 /* Create a new skiplist, returns NULL on error.
  * A comparison callback is required.
@@ -56,7 +187,11 @@ static void *def_alloc(void *p,
  * malloc & free will be used internally. */
 struct skiplist *skiplist_new(skiplist_cmp_cb *cmp,
         skiplist_alloc_cb *alloc, void *alloc_udata) {
+#ifndef SKIPLIST_CMP_INLINE
+    /* With an inlined comparison the callback is unused,
+     * so a NULL cmp is only an error without one. */
     if (cmp == NULL) { return NULL; }
+#endif
     if (alloc == NULL) { alloc = def_alloc; }
 
     struct skiplist *sl = alloc(NULL, 0, sizeof(*sl), alloc_udata);
@@ -65,8 +200,26 @@ struct skiplist *skiplist_new(skiplist_cmp_cb *cmp,
         sl->cmp = cmp;
         sl->alloc = alloc;
         sl->alloc_udata = alloc_udata;
+        sl->deferred = false;
+        sl->epoch = 0;
+        sl->epoch_readers[0] = sl->epoch_readers[1] = 0;
+        sl->limbo[0] = sl->limbo[1] = NULL;
+        sl->concurrent = false;
+        sl->rng = 0;
+        sl->adaptive = false;
+        sl->dtor = NULL;
+        sl->dtor_udata = NULL;
+#if SKIPLIST_FINGERPRINT
+        sl->prefix = NULL;
+#endif
+#if SKIPLIST_STATS
+        sl->stat_bytes = sizeof(*sl);
+        sl->stat_head_grows = 0;
+        sl->stat_searches = 0;
+        sl->stat_cmps = 0;
+#endif
 
-        struct skiplist_node *head = node_alloc(sl, 1, &SENTINEL, &SENTINEL);
+        struct skiplist_node *head = node_alloc(sl, 1, NULL, NULL);
         if (head == NULL) {
             alloc(sl, sizeof(*sl), 0, alloc_udata);
             return NULL;
@@ -78,19 +231,47 @@ struct skiplist *skiplist_new(skiplist_cmp_cb *cmp,
 
 /* Allocate a node. The forward pointers are initialized to &SENTINEL.
  * Returns NULL on failure. */
+static size_t node_size(uint8_t height) {
+    size_t size = sizeof(struct skiplist_node) +
+      height * sizeof(struct skiplist_node *);
+#if SKIPLIST_WIDTHS
+    size += height * sizeof(size_t);
+#endif
+    return size;
+}
+
 static struct skiplist_node *node_alloc(struct skiplist *sl,
         uint8_t height, void *key, void *value) {
     assert(height > 0);
     assert(height <= SKIPLIST_MAX_HEIGHT);
-    size_t size = sizeof(struct skiplist_node) +
-      height * sizeof(struct skiplist_node *);
-    struct skiplist_node *n = sl->alloc(NULL, 0, size, sl->alloc_udata);
+    struct skiplist_node *n = sl->alloc(NULL, 0,
+        node_size(height), sl->alloc_udata);
     if (n == NULL) { return NULL; }
+    STAT_ADD(sl, stat_bytes, node_size(height));
     n->h = height;
+#if SKIPLIST_INLINE_KEY_SIZE > 0
+    if (key) {                  /* NULL for head nodes */
+        memcpy(n->k, key, SKIPLIST_INLINE_KEY_SIZE);
+    } else {
+        memset(n->k, 0, SKIPLIST_INLINE_KEY_SIZE);
+    }
+#else
     n->k = key;
+#endif
+#if SKIPLIST_FINGERPRINT
+    /* Fingerprint the node's own key (its inline copy, if keys are
+     * inlined); head nodes get 0. */
+    n->fp = (key && sl->prefix) ? sl->prefix(NODE_KEY(n)) : 0;
+#endif
     n->v = value;
     LOG2("allocated %d-level node at %p\n", height, (void *)n);
     DO(height, n->next[i] = &SENTINEL);
+#if SKIPLIST_WIDTHS
+    DO(height, NODE_WIDTHS(n)[i] = 1);
+#endif
+#if SKIPLIST_BACK_POINTERS
+    n->prev = NULL;
+#endif
     return n;
 }
 
@@ -112,7 +293,37 @@ static void *def_alloc(void *p,
 /* Free a node. If necessary, everything it references should be
  * freed by the calling function. */
 static void node_free(struct skiplist *sl, struct skiplist_node *n) {
-    sl->alloc(n, sizeof(*n) + n->h * sizeof(n), 0, sl->alloc_udata);
+    STAT_ADD(sl, stat_bytes, -node_size(n->h));
+    sl->alloc(n, node_size(n->h), 0, sl->alloc_udata);
+}
+
+/* Retire a node that has been unlinked from the skiplist: free it
+ * immediately, unless readers are using epochs, in which case it is
+ * kept on the current epoch's limbo list for skiplist_reclaim. */
+static void node_retire(struct skiplist *sl, struct skiplist_node *n) {
+    if (!sl->deferred) {
+        node_free(sl, n);
+        return;
+    }
+    struct skiplist_limbo_node *ln = sl->alloc(NULL, 0,
+        sizeof(*ln), sl->alloc_udata);
+    if (ln == NULL) {
+        /* Can't track it; leaking is safer than freeing under
+         * a concurrent reader. */
+        return;
+    }
+    ln->n = n;
+    if (sl->concurrent) {
+        /* Several writers may retire nodes at once: push with CAS. */
+        for (;;) {
+            unsigned e = SL_LOAD_SC(&sl->epoch);
+            struct skiplist_limbo_node *old = SL_LOAD_SC(&sl->limbo[e & 1]);
+            ln->next = old;
+            if (SL_CAS(&sl->limbo[e & 1], old, ln)) { return; }
+        }
+    }
+    ln->next = sl->limbo[sl->epoch & 1];
+    sl->limbo[sl->epoch & 1] = ln;
 }
 
 /* Set the random seed used when randomly constructing skiplists. */
@@ -120,6 +331,33 @@ void skiplist_set_seed(unsigned seed) {
     srandom(seed);
 }
 
+void skiplist_set_destructor(struct skiplist *sl,
+        skiplist_free_cb *cb, void *udata) {
+    assert(sl);
+    sl->dtor = cb;
+    sl->dtor_udata = udata;
+}
+
+/* Resolve a caller-supplied free callback against the registered
+ * destructor: an explicit CB wins, a NULL one falls back. */
+#define RESOLVE_FREE_CB(sl, cb, udata)                                  \
+    do {                                                                \
+        if ((cb) == NULL) {                                             \
+            (cb) = (sl)->dtor;                                          \
+            (udata) = (sl)->dtor_udata;                                 \
+        }                                                               \
+    } while (0)
+
+#if SKIPLIST_FINGERPRINT
+void skiplist_set_prefix_cb(struct skiplist *sl,
+        skiplist_prefix_cb *prefix) {
+    assert(sl);
+    /* Existing nodes have no fingerprints to compare against. */
+    assert(sl->count == 0);
+    sl->prefix = prefix;
+}
+#endif
+
 #ifndef SKIPLIST_GEN_HEIGHT
 uint8_t SKIPLIST_GEN_HEIGHT(void);
 uint8_t SKIPLIST_GEN_HEIGHT(void) {
@@ -137,31 +375,102 @@ uint8_t SKIPLIST_GEN_HEIGHT(void) {
 }
 #endif
 
+void skiplist_set_seed_local(struct skiplist *sl, uint64_t seed) {
+    assert(sl);
+    /* xorshift state must be nonzero, and 0 means unseeded here. */
+    sl->rng = seed ? seed : UINT64_C(0x9e3779b97f4a7c15);
+}
+
+/* xorshift64*: one word of state, no locks, good enough
+ * bit-mixing for coin flips. */
+static inline uint64_t rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * UINT64_C(2685821657736338717);
+}
+
+void skiplist_set_adaptive_height(struct skiplist *sl, bool adaptive) {
+    assert(sl);
+    sl->adaptive = adaptive;
+}
+
+/* The tallest height worth generating for a list of COUNT pairs:
+ * floor(log2(count)) + 1, the expected height of the tallest node.
+ * The cap rises by one each time the list doubles, so it never
+ * costs search depth; it only trims the tall outliers that a small
+ * list cannot use. */
+static uint8_t height_cap(size_t count) {
+    uint8_t cap = 1;
+    while (count > 1) {
+        count >>= 1;
+        cap++;
+    }
+    return cap > SKIPLIST_MAX_HEIGHT ? SKIPLIST_MAX_HEIGHT : cap;
+}
+
+/* The height for a new node in SL: when the list has its own seeded
+ * PRNG, one random word and a count-trailing-zeros give the
+ * geometric distribution directly (height h has probability 2^-h,
+ * like the bit-by-bit default); otherwise defer to
+ * SKIPLIST_GEN_HEIGHT, which may be user-replaced and by default
+ * calls random() -- which takes a global lock in glibc. */
+static uint8_t gen_height(struct skiplist *sl) {
+    uint8_t h;
+    if (sl->rng == 0) {
+        h = SKIPLIST_GEN_HEIGHT();
+    } else {
+        uint64_t ones = ~rng_next(&sl->rng);    /* trailing 1s of r */
+        h = ones ? (uint8_t)(1 + __builtin_ctzll(ones)) : 64;
+        if (h > SKIPLIST_MAX_HEIGHT) { h = SKIPLIST_MAX_HEIGHT; }
+    }
+    if (sl->adaptive) {
+        uint8_t cap = height_cap(sl->count);
+        if (h > cap) { h = cap; }
+    }
+    return h;
+}
+
 /* Get pointers to the HEIGHT nodes that precede the position
  * for key. Used by add/set/delete/delete_all. */
 static void init_prevs(struct skiplist *sl, void *key,
         struct skiplist_node *head, int height,
-        struct skiplist_node **prevs) {
+        struct skiplist_node **prevs, size_t *ranks) {
     assert(sl);
     assert(head);
     struct skiplist_node *cur = NULL, *next = NULL;
     int lvl = height - 1, res = 0;
+    const uint64_t kfp = KEY_FP(sl, key);
+    (void)ranks;
+#if SKIPLIST_WIDTHS
+    size_t rank = 0;            /* level-0 links from head to cur */
+#endif
 
     cur = head;
     LOG2("sentinel is %p\n", (void *)&SENTINEL);
     LOG2("head is %p\n", (void *)head);
+    STAT_ADD(sl, stat_searches, 1);
 
     do {
         assert(lvl < cur->h);
         assert(cur->h <= SKIPLIST_MAX_HEIGHT);
         next = cur->next[lvl];
         LOG2("next is %p, level is %d\n", (void *)next, lvl);
-        res = IS_SENTINEL(next) ? 1 : sl->cmp(next->k, key);
+        res = IS_SENTINEL(next) ? 1
+            : (STAT_ADD(sl, stat_cmps, 1), NODE_CMP(sl, next, kfp, key));
         LOG2("res is %d\n", res);
         if (res < 0) {              /* < - advance. */
+#if SKIPLIST_WIDTHS
+            rank += NODE_WIDTHS(cur)[lvl];
+#endif
             cur = next;
         } else /*if (res >= 0)*/ {  /* >= - overshot, descend. */
             prevs[lvl] = cur;
+#if SKIPLIST_WIDTHS
+            if (ranks) { ranks[lvl] = rank; }
+#endif
             lvl--;
         }
     } while (lvl >= 0);
@@ -171,18 +480,22 @@ static bool grow_head(struct skiplist *sl, struct skiplist_node *nn) {
     struct skiplist_node *old_head = sl->head;
     LOG2("growing head from %d to %d\n", old_head->h, nn->h);
     struct skiplist_node *new_head = node_alloc(sl, nn->h,
-        &SENTINEL, &SENTINEL);
+        NULL, NULL);
     if (new_head == NULL) {
         fprintf(stderr, "alloc fail\n");
         return false;
     }
     DO(old_head->h, new_head->next[i] = old_head->next[i]);
+#if SKIPLIST_WIDTHS
+    DO(old_head->h, NODE_WIDTHS(new_head)[i] = NODE_WIDTHS(old_head)[i]);
+#endif
     for (int i = old_head->h; i < new_head->h; i++) {
         /* The actual next[i] will be set later. */
         new_head->next[i] = nn;
     }
-    sl->head = new_head;
-    node_free(sl, old_head);
+    SL_STORE_REL(&sl->head, new_head);
+    STAT_ADD(sl, stat_head_grows, 1);
+    node_retire(sl, old_head);
     return true;
 }
 
@@ -193,13 +506,18 @@ static bool add_or_set(struct skiplist *sl, int try_replace,
     assert(head);
     int cur_height = head->h;
     struct skiplist_node *prevs[cur_height];
+#if SKIPLIST_WIDTHS
+    size_t ranks[cur_height];
+#else
+    size_t *ranks = NULL;
+#endif
 
-    init_prevs(sl, key, head, cur_height, prevs);
+    init_prevs(sl, key, head, cur_height, prevs, ranks);
 
     if (try_replace) {
         struct skiplist_node *next = prevs[0]->next[0];
         if (!IS_SENTINEL(next)) {
-            int res = sl->cmp(next->k, key);
+            int res = SL_CMP(sl, NODE_KEY(next), key);
             if (res == 0) { /* key exists, replace value */
                 if (old) { *old = next->v; }
                 next->v = value;
@@ -210,12 +528,26 @@ static bool add_or_set(struct skiplist *sl, int try_replace,
         }
     }
 
-    uint8_t new_height = SKIPLIST_GEN_HEIGHT();
+    return NULL != insert_node(sl, key, value, cur_height, prevs, ranks);
+}
+
+/* Allocate a new node for KEY/VALUE and splice it in after PREVS
+ * (with their level-0 ranks in RANKS, when widths are maintained),
+ * growing the head if the generated height exceeds CUR_HEIGHT.
+ * Shared by add_or_set and the finger operations.
+ * Returns the new node, or NULL on allocation failure. */
+static struct skiplist_node *insert_node(struct skiplist *sl,
+        void *key, void *value, int cur_height,
+        struct skiplist_node **prevs, size_t *ranks) {
+    struct skiplist_node *head = sl->head;
+    (void)ranks;
+
+    uint8_t new_height = gen_height(sl);
     struct skiplist_node *nn = node_alloc(sl, new_height, key, value);
-    if (nn == NULL) { return false; }
+    if (nn == NULL) { return NULL; }
 
     if (new_height > cur_height) {
-        if (!grow_head(sl, nn)) { return false; }
+        if (!grow_head(sl, nn)) { return NULL; }
         DO(cur_height, if (prevs[i] == /* old */ head)
                            prevs[i] = sl->head);
         head = sl->head;
@@ -227,10 +559,31 @@ static bool add_or_set(struct skiplist *sl, int try_replace,
         assert(i < prevs[i]->h);
         nn->next[i] = prevs[i]->next[i];
         assert(prevs[i]->h <= SKIPLIST_MAX_HEIGHT);
-        prevs[i]->next[i] = nn;
+        SL_STORE_REL(&prevs[i]->next[i], nn);
     }
-    sl->count++;
-    return true;
+#if SKIPLIST_BACK_POINTERS
+    back_link(nn, prevs[0], sl->head);
+    back_link(nn->next[0], nn, sl->head);
+#endif
+#if SKIPLIST_WIDTHS
+    /* The new node is at level-0 rank POS; split the width of each
+     * spliced link around it, and stretch the links that skip it. */
+    size_t pos = ranks[0] + 1;
+    for (int i = 0; i < minH; i++) {
+        size_t left = pos - ranks[i];   /* prevs[i] -> nn */
+        NODE_WIDTHS(nn)[i] = NODE_WIDTHS(prevs[i])[i] + 1 - left;
+        NODE_WIDTHS(prevs[i])[i] = left;
+    }
+    for (int i = minH; i < cur_height; i++) {
+        NODE_WIDTHS(prevs[i])[i] += 1;
+    }
+    for (int i = cur_height; i < nn->h; i++) {  /* fresh head levels */
+        NODE_WIDTHS(head)[i] = pos;
+        NODE_WIDTHS(nn)[i] = sl->count + 2 - pos;
+    }
+#endif
+    SL_STORE_REL(&sl->count, sl->count + 1);
+    return nn;
 }
 
 bool skiplist_add(struct skiplist *sl, void *key, void *value) {
@@ -241,180 +594,1129 @@ bool skiplist_set(struct skiplist *sl, void *key, void *value, void **old) {
     return add_or_set(sl, 1, key, value, old);
 }
 
-static bool delete_one_or_all(struct skiplist *sl, void *key,
-        skiplist_free_cb *cb, void *udata, void **old) {
+bool skiplist_update(struct skiplist *sl, void *key,
+        skiplist_update_cb *cb, void *udata) {
     assert(sl);
+    assert(cb);
     struct skiplist_node *head = sl->head;
     int cur_height = head->h;
     struct skiplist_node *prevs[cur_height];
-    init_prevs(sl, key, head, cur_height, prevs);
+#if SKIPLIST_WIDTHS
+    size_t ranks[cur_height];
+#else
+    size_t *ranks = NULL;
+#endif
 
-    struct skiplist_node *doomed = prevs[0]->next[0];
-    if (IS_SENTINEL(doomed) || 0 != sl->cmp(doomed->k, key)) {
-        return false;           /* not found */
-    }
+    init_prevs(sl, key, head, cur_height, prevs, ranks);
 
-    if (cb == NULL) {           /* delete one w/ key */
-        DO(doomed->h, prevs[i]->next[i]=doomed->next[i]);
-        if (old) { *old = doomed->v; }
-        node_free(sl, doomed);
-        sl->count--;
+    struct skiplist_node *next = prevs[0]->next[0];
+    if (!IS_SENTINEL(next) && 0 == SL_CMP(sl, NODE_KEY(next), key)) {
+        (void)cb(key, &next->v, true, udata);
         return true;
-    } else {                    /* delete all w/ key */
-        int res = 0;
-        int tdh = 0;            /* tallest doomed height */
-        struct skiplist_node *nexts[cur_height];
-
-        DO(cur_height, nexts[i] = &SENTINEL);
+    }
+    /* Absent: let the callback supply an initial value, reusing the
+     * search path above for the insert. */
+    void *value = NULL;
+    if (!cb(key, &value, false, udata)) { return false; }
+    return NULL != insert_node(sl, key, value, cur_height, prevs, ranks);
+}
 
-        LOG2("head is %p, sentinel is %p\n", (void *)head, (void *)&SENTINEL);
-        if (SKIPLIST_LOG_LEVEL > 0)
-            DO(cur_height, LOG2("prevs[%i]: %p\n", i, (void *)prevs[i]));
+/* A search finger (see skiplist_finger_new in skiplist.h): the
+ * cached search path from the last operation. PREVS[lvl] is the
+ * rightmost node at that level whose key precedes the last-searched
+ * position, as in init_prevs; only the bottom H levels are valid. */
+struct skiplist_finger {
+    struct skiplist *sl;
+    int h;
+    struct skiplist_node *prevs[SKIPLIST_MAX_HEIGHT];
+#if SKIPLIST_WIDTHS
+    size_t ranks[SKIPLIST_MAX_HEIGHT];
+#endif
+};
 
-        /* Take the prevs, make another array of the first
-         * point beyond the deleted cells at each level, and
-         * link from prev to post. */
-        do {
-            LOG2("doomed is %p\n", (void *)doomed);
-            struct skiplist_node *next = doomed->next[0];
-            assert(next);
-            LOG2("cur tdh: %d, next->h: %d, new tdh: %d\n",
-                tdh, doomed->h, tdh > doomed->h ? tdh : doomed->h);
-            tdh = tdh > doomed->h ? tdh : doomed->h;
+struct skiplist_finger *skiplist_finger_new(struct skiplist *sl) {
+    assert(sl);
+    struct skiplist_finger *f = sl->alloc(NULL, 0,
+        sizeof(*f), sl->alloc_udata);
+    if (f == NULL) { return NULL; }
+    f->sl = sl;
+    f->h = 0;       /* the first search starts from the head */
+    return f;
+}
 
-            /* Maintain proper forward references.
-             * This does some redundant work, and could instead
-             * update to doomed's nexts' that have a greater
-             * key. The added CMPs could be slower, though.*/
-            DO(doomed->h,
-                LOG2("nexts[%d] = doomed->next[%d] (%p)\n",
-                    i, i, (void *)doomed->next[i]);
-                nexts[i] = doomed->next[i]);
-            if (SKIPLIST_LOG_LEVEL > 1)
-                DO(tdh, fprintf(stderr, "nexts[%d] = %p\n", i, (void *)nexts[i]));
+void skiplist_finger_free(struct skiplist_finger *f) {
+    assert(f);
+    struct skiplist *sl = f->sl;
+    sl->alloc(f, sizeof(*f), 0, sl->alloc_udata);
+}
 
-            cb(key, doomed->v, udata);
-            sl->count--;
-            node_free(sl, doomed);
-            res = IS_SENTINEL(next)
-              ? -1 : sl->cmp(next->k, key);
-            doomed = next;
-        } while (res == 0);
+/* Reposition the finger's cached search path at KEY: climb from the
+ * bottom until a cached link brackets the key, then do a standard
+ * descent from there. Each climb roughly doubles the reachable
+ * distance, so the cost is O(log d) in the distance d between the
+ * old and new positions. */
+static void finger_search(struct skiplist_finger *f, void *key) {
+    struct skiplist *sl = f->sl;
+    struct skiplist_node *head = sl->head;
+    int height = head->h;
+    const uint64_t kfp = KEY_FP(sl, key);
+
+    assert(f->h <= height);
+    for (int i = f->h; i < height; i++) {
+        /* Levels the finger hasn't seen yet start at the head. */
+        f->prevs[i] = head;
+#if SKIPLIST_WIDTHS
+        f->ranks[i] = 0;
+#endif
+    }
+    f->h = height;
+
+    /* Climb to the first level whose cached link brackets KEY. The
+     * cached prevs above it are still exact for KEY: any closer
+     * predecessor at a higher level would also appear at this level,
+     * inside the bracketing link. */
+    int lvl = 0;
+    while (lvl < height - 1) {
+        struct skiplist_node *p = f->prevs[lvl];
+        struct skiplist_node *nx = p->next[lvl];
+        bool left_ok = (p == head) || NODE_CMP(sl, p, kfp, key) < 0;
+        bool right_ok = IS_SENTINEL(nx) ||
+            NODE_CMP(sl, nx, kfp, key) >= 0;
+        if (left_ok && right_ok) { break; }
+        lvl++;
+    }
+    if (lvl == height - 1) {    /* only the head brackets everything */
+        struct skiplist_node *p = f->prevs[lvl];
+        if (p != head && NODE_CMP(sl, p, kfp, key) >= 0) {
+            f->prevs[lvl] = head;
+#if SKIPLIST_WIDTHS
+            f->ranks[lvl] = 0;
+#endif
+        }
+    }
 
-        LOG2("tdh is %d\n", tdh);
-        DO(tdh,
-            LOG2("setting prevs[%d]->next[%d] to %p\n", i, i, (void *)nexts[i]);
-            prevs[i]->next[i] = nexts[i]);
-        return false;
+    struct skiplist_node *cur = f->prevs[lvl];
+#if SKIPLIST_WIDTHS
+    size_t rank = f->ranks[lvl];
+#endif
+    for (; lvl >= 0; lvl--) {
+        for (;;) {
+            struct skiplist_node *next = cur->next[lvl];
+            if (IS_SENTINEL(next)) { break; }
+            if (NODE_CMP(sl, next, kfp, key) >= 0) { break; }
+#if SKIPLIST_WIDTHS
+            rank += NODE_WIDTHS(cur)[lvl];
+#endif
+            cur = next;
+        }
+        f->prevs[lvl] = cur;
+#if SKIPLIST_WIDTHS
+        f->ranks[lvl] = rank;
+#endif
     }
 }
 
-bool skiplist_delete(struct skiplist *sl, void *key, void **value) {
-    return delete_one_or_all(sl, key, NULL, NULL, value);
-}
+bool skiplist_add_at(struct skiplist_finger *f, void *key, void *value) {
+    assert(f);
+    struct skiplist *sl = f->sl;
+    finger_search(f, key);
+#if SKIPLIST_WIDTHS
+    size_t *ranks = f->ranks;
+    size_t pos = f->ranks[0] + 1;
+#else
+    size_t *ranks = NULL;
+#endif
 
-void skiplist_delete_all(struct skiplist *sl, void *key,
-        skiplist_free_cb *cb, void *udata) {
-    assert(cb);
-    (void) delete_one_or_all(sl, key, cb, udata, NULL);
+    struct skiplist_node *nn = insert_node(sl, key, value,
+        f->h, f->prevs, ranks);
+    if (nn == NULL) { return false; }
+
+    /* Park the finger at the new node, so an in-order ingest resumes
+     * right here. insert_node already remapped any head prevs if the
+     * head grew. */
+    DO(nn->h, f->prevs[i] = nn);
+#if SKIPLIST_WIDTHS
+    DO(nn->h, f->ranks[i] = pos);
+#endif
+    f->h = sl->head->h;
+    return true;
 }
 
-static struct skiplist_node *get_first_eq_node(struct skiplist *sl, void *key) {
-    assert(sl);
-    struct skiplist_node *head = sl->head;
-    int height = head->h;
-    int lvl = height - 1;
-    struct skiplist_node *cur = head, *next = NULL;
+bool skiplist_get_at(struct skiplist_finger *f, void *key, void **value) {
+    assert(f);
+    struct skiplist *sl = f->sl;
+    (void)sl;   /* unused with SKIPLIST_CMP_INLINE */
+    finger_search(f, key);
+    struct skiplist_node *n = f->prevs[0]->next[0];
+    if (IS_SENTINEL(n) || 0 != SL_CMP(sl, NODE_KEY(n), key)) {
+        return false;
+    }
+    if (value) { *value = n->v; }
+    return true;
+}
 
-    do {
-        assert(cur->h > lvl);
-        next = cur->next[lvl];
+/* Delete the first match for KEY at the finger, keeping the cached
+ * path exact: the prevs that pointed at the doomed node are spliced
+ * past it, which leaves them the correct predecessors. */
+static bool finger_delete(struct skiplist_finger *f, void *key,
+        void **value) {
+    struct skiplist *sl = f->sl;
+    finger_search(f, key);
+    struct skiplist_node *doomed = f->prevs[0]->next[0];
+    if (IS_SENTINEL(doomed) ||
+        0 != SL_CMP(sl, NODE_KEY(doomed), key)) {
+        return false;
+    }
+    if (value) { *value = doomed->v; }
+#if SKIPLIST_WIDTHS
+    DO(doomed->h,
+        NODE_WIDTHS(f->prevs[i])[i] += NODE_WIDTHS(doomed)[i] - 1);
+    for (int i = doomed->h; i < f->h; i++) {
+        NODE_WIDTHS(f->prevs[i])[i] -= 1;
+    }
+#endif
+    DO(doomed->h,
+        assert(f->prevs[i]->next[i] == doomed);
+        SL_STORE_REL(&f->prevs[i]->next[i], doomed->next[i]));
+#if SKIPLIST_BACK_POINTERS
+    back_link(doomed->next[0], f->prevs[0], sl->head);
+#endif
+    SL_STORE_REL(&sl->count, sl->count - 1);
+    node_retire(sl, doomed);
+    return true;
+}
 
-        assert(next->h <= SKIPLIST_MAX_HEIGHT);
-        int res = IS_SENTINEL(next) ? 1 : sl->cmp(next->k, key);
-        if (res < 0) {  /* next->key < key, advance */
-            cur = next;
-        } else if (res >= 0) { /* next->key >= key, descend */
-            /* Descend when == to make sure it's the FIRST match. */
-            if (lvl == 0) {
-                if (res == 0) { return next; } /* found */
-                return NULL;               /* not found */
+/* Stable bottom-up merge sort of the batch's indices by key, so
+ * batch operations walk the list strictly left to right. Sorting
+ * indices (rather than the keys) lets get/delete report results in
+ * the caller's original order. */
+static void sort_batch(struct skiplist *sl, void **keys,
+        size_t *idx, size_t *tmp, size_t count) {
+    (void)sl;   /* unused with SKIPLIST_CMP_INLINE */
+    for (size_t w = 1; w < count; w *= 2) {
+        for (size_t lo = 0; lo < count; lo += 2 * w) {
+            size_t mid = lo + w < count ? lo + w : count;
+            size_t hi = lo + 2 * w < count ? lo + 2 * w : count;
+            size_t a = lo, b = mid, o = lo;
+            while (a < mid && b < hi) {
+                if (SL_CMP(sl, keys[idx[a]], keys[idx[b]]) <= 0) {
+                    tmp[o++] = idx[a++];
+                } else {
+                    tmp[o++] = idx[b++];
+                }
             }
-            lvl--;
+            while (a < mid) { tmp[o++] = idx[a++]; }
+            while (b < hi) { tmp[o++] = idx[b++]; }
         }
-    } while (lvl >= 0);
+        memcpy(idx, tmp, count * sizeof(*idx));
+    }
+}
 
-    return NULL;                 /* not found */
+/* Allocate and sort the index array for a batch of COUNT keys.
+ * Returns NULL on allocation failure. */
+static size_t *batch_order(struct skiplist *sl, void **keys,
+        size_t count) {
+    size_t *idx = sl->alloc(NULL, 0,
+        2 * count * sizeof(*idx), sl->alloc_udata);
+    if (idx == NULL) { return NULL; }
+    for (size_t i = 0; i < count; i++) { idx[i] = i; }
+    sort_batch(sl, keys, idx, idx + count, count);
+    return idx;
 }
 
-bool skiplist_get(struct skiplist *sl, void *key, void **value) {
-    struct skiplist_node *n = get_first_eq_node(sl, key);
-    if (n) {
-        if (value) { *value = n->v; }
-        return true;
-    } else {
-        return false;
-    }
+static void batch_order_free(struct skiplist *sl, size_t *idx,
+        size_t count) {
+    sl->alloc(idx, 2 * count * sizeof(*idx), 0, sl->alloc_udata);
 }
 
-bool skiplist_member(struct skiplist *sl, void *key) {
-    return skiplist_get(sl, key, NULL);
+size_t skiplist_add_batch(struct skiplist *sl, void **keys,
+        void **values, size_t count) {
+    assert(sl);
+    assert(keys);
+    if (count == 0) { return 0; }
+    size_t *idx = batch_order(sl, keys, count);
+    if (idx == NULL) { return 0; }
+
+    struct skiplist_finger f = { .sl = sl, .h = 0 };
+    size_t added = 0;
+    for (size_t i = 0; i < count; i++) {
+        void *v = values ? values[idx[i]] : NULL;
+        if (!skiplist_add_at(&f, keys[idx[i]], v)) { break; }
+        added++;
+    }
+    batch_order_free(sl, idx, count);
+    return added;
 }
 
-bool skiplist_first(struct skiplist *sl, void **key, void **value) {
+size_t skiplist_get_batch(struct skiplist *sl, void **keys,
+        void **values, size_t count) {
     assert(sl);
-    struct skiplist_node *first = sl->head->next[0];
-    if (IS_SENTINEL(first)) { return false; }
-    if (key) { *key = first->k; }
-    if (value) { *value = first->v; }
-    return true;
+    assert(keys);
+    if (count == 0) { return 0; }
+    size_t *idx = batch_order(sl, keys, count);
+    if (idx == NULL) { return 0; }
+
+    struct skiplist_finger f = { .sl = sl, .h = 0 };
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        void *v = NULL;
+        if (skiplist_get_at(&f, keys[idx[i]], &v)) { found++; }
+        if (values) { values[idx[i]] = v; }
+    }
+    batch_order_free(sl, idx, count);
+    return found;
 }
 
-bool skiplist_last(struct skiplist *sl, void **key, void **value) {
+size_t skiplist_delete_batch(struct skiplist *sl, void **keys,
+        void **values, size_t count) {
     assert(sl);
+    assert(keys);
+    if (count == 0) { return 0; }
+    size_t *idx = batch_order(sl, keys, count);
+    if (idx == NULL) { return 0; }
+
+    struct skiplist_finger f = { .sl = sl, .h = 0 };
+    size_t deleted = 0;
+    for (size_t i = 0; i < count; i++) {
+        void *v = NULL;
+        if (finger_delete(&f, keys[idx[i]], &v)) { deleted++; }
+        if (values) { values[idx[i]] = v; }
+    }
+    batch_order_free(sl, idx, count);
+    return deleted;
+}
+
+/* Rolling tails for appending pre-sorted nodes in O(1) each: the
+ * rightmost node at every level, maintained incrementally, so no
+ * top-down searches are needed. Used by the bulk loader and by
+ * deserialization. */
+struct sl_appender {
+    struct skiplist_node *tails[SKIPLIST_MAX_HEIGHT];
+#if SKIPLIST_WIDTHS
+    size_t tail_ranks[SKIPLIST_MAX_HEIGHT];
+#endif
+    void *prev_key;             /* largest key so far, if have_prev */
+    bool have_prev;
+};
+
+static void appender_init(struct skiplist *sl, struct sl_appender *ap) {
     struct skiplist_node *head = sl->head;
-    int lvl = head->h - 1;
-    struct skiplist_node *cur = head->next[lvl];
-    if (IS_SENTINEL(cur)) { return false; }
-    do {
-        struct skiplist_node *next = cur->next[lvl];
-        if (IS_SENTINEL(next)) {
-            lvl--;
-        } else {
-            cur = next;
+#if SKIPLIST_WIDTHS
+    size_t rank = 0;            /* level-0 links from head to cur */
+#endif
+
+    /* Find the rightmost node at every level once. */
+    struct skiplist_node *cur = head;
+    for (int lvl = head->h - 1; lvl >= 0; lvl--) {
+        while (!IS_SENTINEL(cur->next[lvl])) {
+#if SKIPLIST_WIDTHS
+            rank += NODE_WIDTHS(cur)[lvl];
+#endif
+            cur = cur->next[lvl];
         }
-    } while (lvl >= 0);
+        ap->tails[lvl] = cur;
+#if SKIPLIST_WIDTHS
+        ap->tail_ranks[lvl] = rank;
+#endif
+    }
 
-    assert(!IS_SENTINEL(cur));
-    assert(IS_SENTINEL(cur->next[0]));
-    if (key) { *key = cur->k; }
-    if (value) { *value = cur->v; }
-    return true;
+    ap->have_prev = (ap->tails[0] != head);
+    ap->prev_key = ap->have_prev ? NODE_KEY(ap->tails[0]) : NULL;
 }
 
-bool skiplist_pop_first(struct skiplist *sl, void **key, void **value) {
-    int height = 0;
-    assert(sl);
+/* Link NN, which must not sort before any key already present,
+ * at the end of the skiplist. */
+static bool appender_push(struct skiplist *sl, struct sl_appender *ap,
+        struct skiplist_node *nn) {
     struct skiplist_node *head = sl->head;
-    struct skiplist_node *first = head->next[0];
-    assert(first);
-    height = first->h;
-    if (IS_SENTINEL(first)) { return false; }
-    if (key) { *key = first->k; }
-    if (value) { *value = first->v; }
-    sl->count--;
 
-    DO(height, head->next[i] = first->next[i]);
-    node_free(sl, first);
+    if (nn->h > head->h) {
+        int old_height = head->h;
+        if (!grow_head(sl, nn)) { return false; }
+        DO(old_height, if (ap->tails[i] == /* old */ head)
+                           ap->tails[i] = sl->head);
+        /* grow_head already links nn at the new levels. */
+        for (int lvl = old_height; lvl < nn->h; lvl++) {
+            ap->tails[lvl] = sl->head;
+#if SKIPLIST_WIDTHS
+            ap->tail_ranks[lvl] = 0;
+#endif
+        }
+        head = sl->head;
+    }
+
+#if SKIPLIST_WIDTHS
+    size_t pos = sl->count + 1;         /* appending at the end */
+    DO(nn->h,
+        NODE_WIDTHS(ap->tails[i])[i] = pos - ap->tail_ranks[i];
+        NODE_WIDTHS(nn)[i] = 1;
+        ap->tail_ranks[i] = pos);
+    /* Links that skip over the new node get one step longer. */
+    for (int lvl = nn->h; lvl < head->h; lvl++) {
+        NODE_WIDTHS(ap->tails[lvl])[lvl] += 1;
+    }
+#endif
+#if SKIPLIST_BACK_POINTERS
+    back_link(nn, ap->tails[0], sl->head);
+#endif
+    DO(nn->h,
+        assert(IS_SENTINEL(ap->tails[i]->next[i]) || ap->tails[i]->next[i] == nn);
+        nn->next[i] = &SENTINEL;
+        SL_STORE_REL(&ap->tails[i]->next[i], nn);
+        ap->tails[i] = nn);
+    SL_STORE_REL(&sl->count, sl->count + 1);
+    ap->prev_key = NODE_KEY(nn);
+    ap->have_prev = true;
     return true;
 }
 
-bool skiplist_pop_last(struct skiplist *sl, void **key, void **value) {
+bool skiplist_load_sorted(struct skiplist *sl,
+        void **keys, void **values, size_t count) {
     assert(sl);
-    struct skiplist_node *head = sl->head;
-    struct skiplist_node *prevs[head->h];
-    int lvl = head->h - 1;
-    struct skiplist_node *cur = head;
+    if (keys == NULL) { return false; }
+    struct sl_appender ap;
+    appender_init(sl, &ap);
+
+    for (size_t pair = 0; pair < count; pair++) {
+        void *key = keys[pair];
+        void *value = values ? values[pair] : NULL;
+        if (ap.have_prev && SL_CMP(sl, key, ap.prev_key) < 0) {
+            return false;       /* out of order */
+        }
+
+        uint8_t new_height = gen_height(sl);
+        struct skiplist_node *nn = node_alloc(sl, new_height, key, value);
+        if (nn == NULL) { return false; }
+        if (!appender_push(sl, &ap, nn)) { return false; }
+    }
+    return true;
+}
+
+bool skiplist_merge(struct skiplist *dst, struct skiplist *src) {
+    assert(dst);
+    assert(src);
+    assert(dst != src);
+    /* DST will eventually free the stolen nodes. */
+    assert(dst->alloc == src->alloc);
+    assert(dst->alloc_udata == src->alloc_udata);
+
+    /* Make DST's head tall enough up front: then nothing in the
+     * merge loop can fail, since no node is taller than the head it
+     * came from. */
+    if (src->head->h > dst->head->h) {
+        struct skiplist_node *nh = node_alloc(dst, src->head->h,
+            NULL, NULL);
+        if (nh == NULL) { return false; }
+        DO(dst->head->h, nh->next[i] = dst->head->next[i]);
+#if SKIPLIST_WIDTHS
+        DO(dst->head->h,
+            NODE_WIDTHS(nh)[i] = NODE_WIDTHS(dst->head)[i]);
+        for (int i = dst->head->h; i < nh->h; i++) {
+            NODE_WIDTHS(nh)[i] = dst->count + 1;
+        }
+#endif
+        struct skiplist_node *oh = dst->head;
+        SL_STORE_REL(&dst->head, nh);
+        node_retire(dst, oh);
+    }
+
+    /* Detach both level-0 chains, then rebuild DST by appending
+     * nodes in merged order through the rolling tails. Each node
+     * keeps its height (appender_push relinks it from scratch), so
+     * the expected level structure is preserved. DST wins ties, so
+     * the merge is stable. */
+    struct skiplist_node *a = dst->head->next[0];
+    struct skiplist_node *b = src->head->next[0];
+    DO(dst->head->h, dst->head->next[i] = &SENTINEL);
+    DO(src->head->h, src->head->next[i] = &SENTINEL);
+#if SKIPLIST_WIDTHS
+    DO(dst->head->h, NODE_WIDTHS(dst->head)[i] = 1);
+    DO(src->head->h, NODE_WIDTHS(src->head)[i] = 1);
+#endif
+    SL_STORE_REL(&dst->count, 0);
+    SL_STORE_REL(&src->count, 0);
+
+    struct sl_appender ap;
+    appender_init(dst, &ap);
+
+    while (!IS_SENTINEL(a) || !IS_SENTINEL(b)) {
+        struct skiplist_node *nn = NULL;
+        if (IS_SENTINEL(b) ||
+            (!IS_SENTINEL(a) &&
+             SL_CMP(dst, NODE_KEY(a), NODE_KEY(b)) <= 0)) {
+            nn = a;
+            a = a->next[0];
+        } else {
+            nn = b;
+            b = b->next[0];
+        }
+        bool pushed = appender_push(dst, &ap, nn);
+        assert(pushed);         /* the head is already tall enough */
+        (void)pushed;
+    }
+    return true;
+}
+
+struct skiplist *skiplist_split(struct skiplist *sl, void *key) {
+    assert(sl);
+    struct skiplist_node *head = sl->head;
+    int cur_height = head->h;
+    struct skiplist_node *prevs[cur_height];
+#if SKIPLIST_WIDTHS
+    size_t ranks[cur_height];
+#else
+    size_t *ranks = NULL;
+#endif
+    init_prevs(sl, key, head, cur_height, prevs, ranks);
+
+    struct skiplist *out = skiplist_new(sl->cmp, sl->alloc,
+        sl->alloc_udata);
+    if (out == NULL) { return NULL; }
+    if (cur_height > 1) {       /* match SL's head height */
+        struct skiplist_node *nh = node_alloc(out, cur_height,
+            NULL, NULL);
+        if (nh == NULL) {
+            skiplist_free(out, NULL, NULL);
+            return NULL;
+        }
+        node_free(out, out->head);
+        out->head = nh;
+    }
+    /* A locally-seeded list hands its split a fresh seed; the
+     * destructor follows the data. */
+    out->rng = sl->rng ? rng_next(&sl->rng) : 0;
+    out->dtor = sl->dtor;
+    out->dtor_udata = sl->dtor_udata;
+#if SKIPLIST_FINGERPRINT
+    out->prefix = sl->prefix;
+#endif
+
+#if SKIPLIST_WIDTHS
+    size_t moved = sl->count - ranks[0];
+#else
+    size_t moved = 0;
+    for (struct skiplist_node *n = prevs[0]->next[0];
+         !IS_SENTINEL(n); n = n->next[0]) {
+        moved++;
+    }
+#endif
+
+    /* Sever each level at the pivot: everything from the first
+     * key >= KEY onward hangs off OUT's head. */
+#if SKIPLIST_WIDTHS
+    size_t pr = ranks[0];       /* keys staying in SL */
+    DO(cur_height,
+        NODE_WIDTHS(out->head)[i] =
+            ranks[i] + NODE_WIDTHS(prevs[i])[i] - pr;
+        NODE_WIDTHS(prevs[i])[i] = pr + 1 - ranks[i]);
+#endif
+    DO(cur_height,
+        out->head->next[i] = prevs[i]->next[i];
+        SL_STORE_REL(&prevs[i]->next[i], &SENTINEL));
+#if SKIPLIST_BACK_POINTERS
+    /* The pivot node is now OUT's first. */
+    back_link(out->head->next[0], out->head, out->head);
+#endif
+
+    SL_STORE_REL(&out->count, moved);
+    SL_STORE_REL(&sl->count, sl->count - moved);
+    return out;
+}
+
+/* On-stream format: a fixed header, then one record per pair in key
+ * order: a single height byte followed by the user-encoded key and
+ * value. Numeric fields are in the machine's native byte order. */
+struct sl_stream_header {
+    char magic[4];              /* SL_STREAM_MAGIC */
+    uint8_t version;
+    uint8_t max_height;
+    uint8_t pad[2];
+    uint64_t count;
+};
+#define SL_STREAM_MAGIC "skpl"
+#define SL_STREAM_VERSION 1
+
+bool skiplist_serialize(struct skiplist *sl, skiplist_write_cb *write,
+        skiplist_encode_cb *encode, void *udata) {
+    assert(sl);
+    assert(write);
+    assert(encode);
+    struct sl_stream_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SL_STREAM_MAGIC, sizeof(hdr.magic));
+    hdr.version = SL_STREAM_VERSION;
+    hdr.max_height = SKIPLIST_MAX_HEIGHT;
+    hdr.count = sl->count;
+    if (!write(&hdr, sizeof(hdr), udata)) { return false; }
+
+    for (struct skiplist_node *n = sl->head->next[0];
+         !IS_SENTINEL(n); n = n->next[0]) {
+        uint8_t h = (uint8_t)n->h;
+        if (!write(&h, sizeof(h), udata)) { return false; }
+        if (!encode(NODE_KEY(n), n->v, write, udata)) { return false; }
+    }
+    return true;
+}
+
+struct skiplist *skiplist_deserialize(skiplist_read_cb *read,
+        skiplist_decode_cb *decode, void *udata, skiplist_cmp_cb *cmp,
+        skiplist_alloc_cb *alloc, void *alloc_udata) {
+    assert(read);
+    assert(decode);
+    struct sl_stream_header hdr;
+    if (!read(&hdr, sizeof(hdr), udata)) { return NULL; }
+    if (0 != memcmp(hdr.magic, SL_STREAM_MAGIC, sizeof(hdr.magic)) ||
+        hdr.version != SL_STREAM_VERSION ||
+        hdr.max_height > SKIPLIST_MAX_HEIGHT) {
+        return NULL;
+    }
+
+    struct skiplist *sl = skiplist_new(cmp, alloc, alloc_udata);
+    if (sl == NULL) { return NULL; }
+    struct sl_appender ap;
+    appender_init(sl, &ap);
+
+    /* The stored heights make height generation and searching both
+     * unnecessary: every pair is appended through the rolling tails,
+     * rebuilding all levels in one O(n) pass. */
+    for (uint64_t pair = 0; pair < hdr.count; pair++) {
+        uint8_t h = 0;
+        void *key = NULL, *value = NULL;
+        if (!read(&h, sizeof(h), udata) ||
+            h < 1 || h > hdr.max_height ||
+            !decode(&key, &value, read, udata)) {
+            goto fail;
+        }
+        if (ap.have_prev && SL_CMP(sl, key, ap.prev_key) < 0) {
+            goto fail;          /* stream is not in key order */
+        }
+        struct skiplist_node *nn = node_alloc(sl, h, key, value);
+        if (nn == NULL || !appender_push(sl, &ap, nn)) { goto fail; }
+    }
+    return sl;
+
+fail:
+    skiplist_free(sl, NULL, NULL);
+    return NULL;
+}
+
+static bool delete_one_or_all(struct skiplist *sl, void *key, bool all,
+        skiplist_free_cb *cb, void *udata, void **old) {
+    assert(sl);
+    struct skiplist_node *head = sl->head;
+    int cur_height = head->h;
+    struct skiplist_node *prevs[cur_height];
+#if SKIPLIST_WIDTHS
+    size_t ranks[cur_height];
+#else
+    size_t *ranks = NULL;
+#endif
+    init_prevs(sl, key, head, cur_height, prevs, ranks);
+
+    struct skiplist_node *doomed = prevs[0]->next[0];
+    if (IS_SENTINEL(doomed) || 0 != SL_CMP(sl, NODE_KEY(doomed), key)) {
+        return false;           /* not found */
+    }
+
+    if (!all) {                 /* delete one w/ key */
+#if SKIPLIST_WIDTHS
+        DO(doomed->h,
+            NODE_WIDTHS(prevs[i])[i] += NODE_WIDTHS(doomed)[i] - 1);
+        for (int i = doomed->h; i < cur_height; i++) {
+            NODE_WIDTHS(prevs[i])[i] -= 1;
+        }
+#endif
+        DO(doomed->h, SL_STORE_REL(&prevs[i]->next[i], doomed->next[i]));
+#if SKIPLIST_BACK_POINTERS
+        back_link(doomed->next[0], prevs[0], sl->head);
+#endif
+        if (old) { *old = doomed->v; }
+        node_retire(sl, doomed);
+        SL_STORE_REL(&sl->count, sl->count - 1);
+        return true;
+    } else {                    /* delete all w/ key */
+        int res = 0;
+        int tdh = 0;            /* tallest doomed height */
+        struct skiplist_node *nexts[cur_height];
+#if SKIPLIST_WIDTHS
+        size_t ct = 0;
+        size_t dr = ranks[0];   /* level-0 rank of the doomed node */
+        size_t nextranks[cur_height];
+        DO(cur_height, nextranks[i] = 0);
+#endif
+
+        DO(cur_height, nexts[i] = &SENTINEL);
+
+        LOG2("head is %p, sentinel is %p\n", (void *)head, (void *)&SENTINEL);
+        if (SKIPLIST_LOG_LEVEL > 0)
+            DO(cur_height, LOG2("prevs[%i]: %p\n", i, (void *)prevs[i]));
+
+        /* Take the prevs, make another array of the first
+         * point beyond the deleted cells at each level, and
+         * link from prev to post. */
+        do {
+            LOG2("doomed is %p\n", (void *)doomed);
+            struct skiplist_node *next = doomed->next[0];
+            assert(next);
+            LOG2("cur tdh: %d, next->h: %d, new tdh: %d\n",
+                tdh, doomed->h, tdh > doomed->h ? tdh : doomed->h);
+            tdh = tdh > doomed->h ? tdh : doomed->h;
+
+            /* Maintain proper forward references.
+             * This does some redundant work, and could instead
+             * update to doomed's nexts' that have a greater
+             * key. The added CMPs could be slower, though.*/
+            DO(doomed->h,
+                LOG2("nexts[%d] = doomed->next[%d] (%p)\n",
+                    i, i, (void *)doomed->next[i]);
+                nexts[i] = doomed->next[i]);
+#if SKIPLIST_WIDTHS
+            ct++;
+            dr++;
+            DO(doomed->h, nextranks[i] = dr + NODE_WIDTHS(doomed)[i]);
+#endif
+            if (SKIPLIST_LOG_LEVEL > 1)
+                DO(tdh, fprintf(stderr, "nexts[%d] = %p\n", i, (void *)nexts[i]));
+
+            if (cb) { cb(key, doomed->v, udata); }
+            SL_STORE_REL(&sl->count, sl->count - 1);
+            node_retire(sl, doomed);
+            res = IS_SENTINEL(next)
+              ? -1 : SL_CMP(sl, NODE_KEY(next), key);
+            doomed = next;
+        } while (res == 0);
+
+        LOG2("tdh is %d\n", tdh);
+#if SKIPLIST_WIDTHS
+        /* Re-derive the spliced links' widths from the ranks the
+         * nodes beyond the span had before CT nodes were removed. */
+        DO(tdh, NODE_WIDTHS(prevs[i])[i] = nextranks[i] - ct - ranks[i]);
+        for (int i = tdh; i < cur_height; i++) {
+            NODE_WIDTHS(prevs[i])[i] -= ct;
+        }
+#endif
+        DO(tdh,
+            LOG2("setting prevs[%d]->next[%d] to %p\n", i, i, (void *)nexts[i]);
+            SL_STORE_REL(&prevs[i]->next[i], nexts[i]));
+#if SKIPLIST_BACK_POINTERS
+        back_link(nexts[0], prevs[0], sl->head);
+#endif
+        return false;
+    }
+}
+
+bool skiplist_delete(struct skiplist *sl, void *key, void **value) {
+    return delete_one_or_all(sl, key, false, NULL, NULL, value);
+}
+
+void skiplist_delete_all(struct skiplist *sl, void *key,
+        skiplist_free_cb *cb, void *udata) {
+    RESOLVE_FREE_CB(sl, cb, udata);
+    (void) delete_one_or_all(sl, key, true, cb, udata, NULL);
+}
+
+size_t skiplist_delete_range(struct skiplist *sl,
+        void *min_key, void *max_key,
+        skiplist_free_cb *cb, void *udata) {
+    assert(sl);
+    RESOLVE_FREE_CB(sl, cb, udata);
+    struct skiplist_node *head = sl->head;
+    assert(head);
+    int cur_height = head->h;
+    struct skiplist_node *prevs[cur_height];
+#if SKIPLIST_WIDTHS
+    size_t ranks[cur_height];
+#else
+    size_t *ranks = NULL;
+#endif
+
+    init_prevs(sl, min_key, head, cur_height, prevs, ranks);
+
+    struct skiplist_node *doomed = prevs[0]->next[0];
+    if (IS_SENTINEL(doomed) ||
+        SL_CMP(sl, NODE_KEY(doomed), max_key) > 0) {
+        return 0;               /* no keys in [min_key, max_key] */
+    }
+
+    /* Walk the doomed span once, tracking the first node beyond it
+     * at each level (the nexts[] technique from delete_all), then
+     * splice the prevs past the whole span. */
+    int tdh = 0;                /* tallest doomed height */
+    struct skiplist_node *nexts[cur_height];
+    DO(cur_height, nexts[i] = &SENTINEL);
+#if SKIPLIST_WIDTHS
+    size_t dr = ranks[0];       /* level-0 rank of the doomed node */
+    size_t nextranks[cur_height];
+    DO(cur_height, nextranks[i] = 0);
+#endif
+
+    size_t ct = 0;
+    do {
+        struct skiplist_node *next = doomed->next[0];
+        assert(next);
+        tdh = tdh > doomed->h ? tdh : doomed->h;
+        DO(doomed->h, nexts[i] = doomed->next[i]);
+#if SKIPLIST_WIDTHS
+        dr++;
+        DO(doomed->h, nextranks[i] = dr + NODE_WIDTHS(doomed)[i]);
+#endif
+        if (cb) { cb(NODE_KEY(doomed), doomed->v, udata); }
+        node_retire(sl, doomed);
+        ct++;
+        doomed = next;
+    } while (!IS_SENTINEL(doomed) &&
+        SL_CMP(sl, NODE_KEY(doomed), max_key) <= 0);
+
+#if SKIPLIST_WIDTHS
+    DO(tdh, NODE_WIDTHS(prevs[i])[i] = nextranks[i] - ct - ranks[i]);
+    for (int i = tdh; i < cur_height; i++) {
+        NODE_WIDTHS(prevs[i])[i] -= ct;
+    }
+#endif
+    DO(tdh, SL_STORE_REL(&prevs[i]->next[i], nexts[i]));
+#if SKIPLIST_BACK_POINTERS
+    back_link(nexts[0], prevs[0], sl->head);
+#endif
+    SL_STORE_REL(&sl->count, sl->count - ct);
+    return ct;
+}
+
+/* Get the first node whose key is >= KEY, or &SENTINEL if every
+ * key in the skiplist is less than KEY. */
+static struct skiplist_node *get_first_geq_node(struct skiplist *sl, void *key) {
+    assert(sl);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    int height = head->h;
+    int lvl = height - 1;
+    struct skiplist_node *cur = head, *next = NULL;
+    const uint64_t kfp = KEY_FP(sl, key);
+    STAT_ADD(sl, stat_searches, 1);
+
+    do {
+        assert(cur->h > lvl);
+        next = SL_LOAD_ACQ(&cur->next[lvl]);
+
+        assert(next->h <= SKIPLIST_MAX_HEIGHT);
+        int res = IS_SENTINEL(next) ? 1
+            : (STAT_ADD(sl, stat_cmps, 1), NODE_CMP(sl, next, kfp, key));
+        if (res < 0) {  /* next->key < key, advance */
+            cur = next;
+        } else if (res >= 0) { /* next->key >= key, descend */
+            /* Descend when == to make sure it's the FIRST match. */
+            if (lvl == 0) { return next; }
+            lvl--;
+        }
+    } while (lvl >= 0);
+
+    return &SENTINEL;            /* not reached */
+}
+
+static struct skiplist_node *get_first_eq_node(struct skiplist *sl, void *key) {
+    struct skiplist_node *n = get_first_geq_node(sl, key);
+    if (IS_SENTINEL(n) || 0 != SL_CMP(sl, NODE_KEY(n), key)) {
+        return NULL;             /* not found */
+    }
+    return n;
+}
+
+bool skiplist_get(struct skiplist *sl, void *key, void **value) {
+    struct skiplist_node *n = get_first_eq_node(sl, key);
+    if (n) {
+        if (value) { *value = n->v; }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool skiplist_member(struct skiplist *sl, void *key) {
+    return skiplist_get(sl, key, NULL);
+}
+
+/* get_first_geq_node, comparing stored keys against PROBE with a
+ * caller-supplied comparator instead of the list's own:
+ * pcmp(probe, key) > 0 means the probe sorts after the stored key.
+ * Key-prefix fingerprints cannot be consulted -- there is no
+ * materialized key to hash -- so every step pays a full
+ * comparison. */
+static struct skiplist_node *get_first_geq_node_ex(struct skiplist *sl,
+        void *probe, skiplist_probe_cmp_cb *pcmp) {
+    assert(sl);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    int lvl = head->h - 1;
+    struct skiplist_node *cur = head, *next = NULL;
+    STAT_ADD(sl, stat_searches, 1);
+
+    do {
+        assert(cur->h > lvl);
+        next = SL_LOAD_ACQ(&cur->next[lvl]);
+        int res = IS_SENTINEL(next) ? -1
+            : (STAT_ADD(sl, stat_cmps, 1), pcmp(probe, NODE_KEY(next)));
+        if (res > 0) {          /* probe > next->key, advance */
+            cur = next;
+        } else {                /* next->key >= probe, descend */
+            /* Descend when == to make sure it's the FIRST match. */
+            if (lvl == 0) { return next; }
+            lvl--;
+        }
+    } while (lvl >= 0);
+
+    return &SENTINEL;            /* not reached */
+}
+
+static struct skiplist_node *get_first_eq_node_ex(struct skiplist *sl,
+        void *probe, skiplist_probe_cmp_cb *pcmp) {
+    struct skiplist_node *n = get_first_geq_node_ex(sl, probe, pcmp);
+    if (IS_SENTINEL(n) || 0 != pcmp(probe, NODE_KEY(n))) {
+        return NULL;             /* not found */
+    }
+    return n;
+}
+
+bool skiplist_get_ex(struct skiplist *sl, void *probe,
+        skiplist_probe_cmp_cb *pcmp, void **value) {
+    assert(pcmp);
+    struct skiplist_node *n = get_first_eq_node_ex(sl, probe, pcmp);
+    if (n) {
+        if (value) { *value = n->v; }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool skiplist_member_ex(struct skiplist *sl, void *probe,
+        skiplist_probe_cmp_cb *pcmp) {
+    return skiplist_get_ex(sl, probe, pcmp, NULL);
+}
+
+/* How many searches skiplist_get_many keeps in flight at once. Each
+ * lane's next node is prefetched while the other lanes' comparisons
+ * run, so this should cover the memory latency without overflowing
+ * the load buffers; 8 works well on current hardware. */
+#define GET_MANY_LANES 8
+
+/* One in-flight search: the probe key (and its fingerprint), the
+ * current descent position, and the already-prefetched node that the
+ * next step will compare against. */
+struct get_many_lane {
+    size_t idx;                 /* index into keys[]/values[] */
+    int lvl;
+    uint64_t kfp;
+    struct skiplist_node *cur;
+    struct skiplist_node *next;
+};
+
+size_t skiplist_get_many(struct skiplist *sl, void **keys,
+        void **values, size_t count) {
+    assert(sl);
+    assert(keys);
+    assert(values);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    const int top = head->h - 1;
+
+    struct get_many_lane lanes[GET_MANY_LANES];
+    int nlanes = 0;
+    size_t next_key = 0, found = 0;
+
+    while (next_key < count && nlanes < GET_MANY_LANES) {
+        struct get_many_lane *ln = &lanes[nlanes++];
+        ln->idx = next_key;
+        ln->lvl = top;
+        ln->kfp = KEY_FP(sl, keys[next_key]);
+        ln->cur = head;
+        ln->next = SL_LOAD_ACQ(&head->next[top]);
+        SL_PREFETCH(ln->next);
+        next_key++;
+    }
+    STAT_ADD(sl, stat_searches, (uint64_t)nlanes);
+
+    /* Round-robin: advance each search one step per pass. Each step
+     * compares against a node prefetched a full pass ago, then kicks
+     * off the prefetch for its next one, so the serial load-compare-
+     * load chain of a single search overlaps with the others'. */
+    while (nlanes > 0) {
+        for (int l = 0; l < nlanes; l++) {
+            struct get_many_lane *ln = &lanes[l];
+            struct skiplist_node *next = ln->next;
+            void *key = keys[ln->idx];
+            int res = IS_SENTINEL(next) ? 1
+                : (STAT_ADD(sl, stat_cmps, 1),
+                    NODE_CMP(sl, next, ln->kfp, key));
+            if (res < 0) {          /* advance */
+                ln->cur = next;
+            } else if (ln->lvl > 0) {  /* descend */
+                ln->lvl--;
+            } else {                /* done: hit iff the keys match */
+                if (res == 0) {
+                    values[ln->idx] = next->v;
+                    found++;
+                } else {
+                    values[ln->idx] = NULL;
+                }
+                if (next_key < count) {     /* refill the lane */
+                    ln->idx = next_key;
+                    ln->lvl = top;
+                    ln->kfp = KEY_FP(sl, keys[next_key]);
+                    ln->cur = head;
+                    next_key++;
+                    STAT_ADD(sl, stat_searches, 1);
+                } else {                    /* retire it */
+                    lanes[l] = lanes[--nlanes];
+                    l--;
+                    continue;
+                }
+            }
+            ln->next = SL_LOAD_ACQ(&ln->cur->next[ln->lvl]);
+            SL_PREFETCH(ln->next);
+        }
+    }
+    return found;
+}
+
+bool skiplist_ceiling(struct skiplist *sl, void *key,
+        void **out_key, void **out_value) {
+    struct skiplist_node *n = get_first_geq_node(sl, key);
+    if (IS_SENTINEL(n)) { return false; }
+    if (out_key) { *out_key = NODE_KEY(n); }
+    if (out_value) { *out_value = n->v; }
+    return true;
+}
+
+/* Get the last node whose key is <= KEY, or &SENTINEL if every key
+ * in the skiplist is greater: the mirror image of
+ * get_first_geq_node, advancing through equal keys so duplicates
+ * yield the last match. */
+static struct skiplist_node *get_last_leq_node(struct skiplist *sl,
+        void *key) {
+    assert(sl);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    struct skiplist_node *cur = head;
+    const uint64_t kfp = KEY_FP(sl, key);
+
+    for (int lvl = head->h - 1; lvl >= 0; lvl--) {
+        for (;;) {
+            struct skiplist_node *next = SL_LOAD_ACQ(&cur->next[lvl]);
+            if (IS_SENTINEL(next)) { break; }
+            if (NODE_CMP(sl, next, kfp, key) > 0) { break; }
+            cur = next;
+        }
+    }
+    return cur == head ? &SENTINEL : cur;
+}
+
+bool skiplist_floor(struct skiplist *sl, void *key,
+        void **out_key, void **out_value) {
+    struct skiplist_node *n = get_last_leq_node(sl, key);
+    if (IS_SENTINEL(n)) { return false; }
+    if (out_key) { *out_key = NODE_KEY(n); }
+    if (out_value) { *out_value = n->v; }
+    return true;
+}
+
+bool skiplist_ceiling_ex(struct skiplist *sl, void *probe,
+        skiplist_probe_cmp_cb *pcmp, void **out_key, void **out_value) {
+    assert(pcmp);
+    struct skiplist_node *n = get_first_geq_node_ex(sl, probe, pcmp);
+    if (IS_SENTINEL(n)) { return false; }
+    if (out_key) { *out_key = NODE_KEY(n); }
+    if (out_value) { *out_value = n->v; }
+    return true;
+}
+
+/* get_last_leq_node with a probe comparator, for skiplist_floor_ex:
+ * the last node whose key is <= the probe, advancing through equal
+ * keys so duplicates yield the last match. */
+static struct skiplist_node *get_last_leq_node_ex(struct skiplist *sl,
+        void *probe, skiplist_probe_cmp_cb *pcmp) {
+    assert(sl);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    struct skiplist_node *cur = head;
+
+    for (int lvl = head->h - 1; lvl >= 0; lvl--) {
+        for (;;) {
+            struct skiplist_node *next = SL_LOAD_ACQ(&cur->next[lvl]);
+            if (IS_SENTINEL(next)) { break; }
+            if (pcmp(probe, NODE_KEY(next)) < 0) { break; }
+            cur = next;
+        }
+    }
+    return cur == head ? &SENTINEL : cur;
+}
+
+bool skiplist_floor_ex(struct skiplist *sl, void *probe,
+        skiplist_probe_cmp_cb *pcmp, void **out_key, void **out_value) {
+    assert(pcmp);
+    struct skiplist_node *n = get_last_leq_node_ex(sl, probe, pcmp);
+    if (IS_SENTINEL(n)) { return false; }
+    if (out_key) { *out_key = NODE_KEY(n); }
+    if (out_value) { *out_value = n->v; }
+    return true;
+}
+
+bool skiplist_first(struct skiplist *sl, void **key, void **value) {
+    assert(sl);
+    struct skiplist_node *first = SL_LOAD_ACQ(&SL_LOAD_ACQ(&sl->head)->next[0]);
+    if (IS_SENTINEL(first)) { return false; }
+    if (key) { *key = NODE_KEY(first); }
+    if (value) { *value = first->v; }
+    return true;
+}
+
+bool skiplist_last(struct skiplist *sl, void **key, void **value) {
+    assert(sl);
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    int lvl = head->h - 1;
+    struct skiplist_node *cur = SL_LOAD_ACQ(&head->next[lvl]);
+    if (IS_SENTINEL(cur)) { return false; }
+    do {
+        struct skiplist_node *next = SL_LOAD_ACQ(&cur->next[lvl]);
+        if (IS_SENTINEL(next)) {
+            lvl--;
+        } else {
+            cur = next;
+        }
+    } while (lvl >= 0);
+
+    assert(!IS_SENTINEL(cur));
+    assert(IS_SENTINEL(cur->next[0]));
+    if (key) { *key = NODE_KEY(cur); }
+    if (value) { *value = cur->v; }
+    return true;
+}
+
+bool skiplist_pop_first(struct skiplist *sl, void **key, void **value) {
+    int height = 0;
+    assert(sl);
+    struct skiplist_node *head = sl->head;
+    struct skiplist_node *first = head->next[0];
+    assert(first);
+    height = first->h;
+    if (IS_SENTINEL(first)) { return false; }
+    if (key) { *key = NODE_KEY(first); }
+    if (value) { *value = first->v; }
+    SL_STORE_REL(&sl->count, sl->count - 1);
+
+#if SKIPLIST_WIDTHS
+    DO(height, NODE_WIDTHS(head)[i] += NODE_WIDTHS(first)[i] - 1);
+    for (int i = height; i < head->h; i++) {
+        NODE_WIDTHS(head)[i] -= 1;
+    }
+#endif
+    DO(height, SL_STORE_REL(&head->next[i], first->next[i]));
+#if SKIPLIST_BACK_POINTERS
+    back_link(first->next[0], head, head);
+#endif
+    node_retire(sl, first);
+    return true;
+}
+
+bool skiplist_pop_last(struct skiplist *sl, void **key, void **value) {
+    assert(sl);
+    struct skiplist_node *head = sl->head;
+    struct skiplist_node *prevs[head->h];
+    int lvl = head->h - 1;
+    struct skiplist_node *cur = head;
     if (sl->count == 0) { return false; }
 
     /* Get all the nodes that are (node -> last -> &SENTINEL) so
@@ -438,40 +1740,108 @@ bool skiplist_pop_last(struct skiplist *sl, void **key, void **value) {
 
     /* skip over the last non-SENTINEL nodes. */
     DO(cur->h, assert(prevs[i]->next[i] == cur));
-    DO(cur->h, prevs[i]->next[i] = &SENTINEL);
+#if SKIPLIST_WIDTHS
+    DO(cur->h, NODE_WIDTHS(prevs[i])[i] += NODE_WIDTHS(cur)[i] - 1);
+    /* Above the last pair's height, prevs[i] may sit one node short
+     * of the level's tail; it is the tail's link to the sentinel
+     * that spans the deleted rank. */
+    for (int i = cur->h; i < head->h; i++) {
+        struct skiplist_node *tail = prevs[i];
+        if (!IS_SENTINEL(tail->next[i])) { tail = tail->next[i]; }
+        assert(IS_SENTINEL(tail->next[i]));
+        NODE_WIDTHS(tail)[i] -= 1;
+    }
+#endif
+    DO(cur->h, SL_STORE_REL(&prevs[i]->next[i], &SENTINEL));
 
-    if (key) { *key = cur->k; }
+    if (key) { *key = NODE_KEY(cur); }
     if (value) { *value = cur->v; }
-    sl->count--;
+    SL_STORE_REL(&sl->count, sl->count - 1);
 
     assert(!IS_SENTINEL(cur));
-    node_free(sl, cur);
+    node_retire(sl, cur);
     return true;
 }
 
 size_t skiplist_count(struct skiplist *sl) {
     assert(sl);
-    return sl->count;
+    return SL_LOAD_ACQ(&sl->count);
 }
 
 bool skiplist_empty(struct skiplist *sl) {
     return (skiplist_count(sl) == 0);
 }
 
+#if SKIPLIST_WIDTHS
+/* Count the keys before KEY by summing span widths during a search
+ * descent: < KEY, or <= KEY when INCLUSIVE. */
+static size_t rank_of_key(struct skiplist *sl, void *key, bool inclusive) {
+    struct skiplist_node *head = sl->head;
+    struct skiplist_node *cur = head;
+    size_t rank = 0;
+
+    for (int lvl = head->h - 1; lvl >= 0; lvl--) {
+        for (;;) {
+            struct skiplist_node *next = cur->next[lvl];
+            if (IS_SENTINEL(next)) { break; }
+            int res = SL_CMP(sl, NODE_KEY(next), key);
+            if (res < 0 || (inclusive && res == 0)) {
+                rank += NODE_WIDTHS(cur)[lvl];
+                cur = next;
+            } else {
+                break;
+            }
+        }
+    }
+    return rank;
+}
+
+size_t skiplist_count_range(struct skiplist *sl,
+        void *min_key, void *max_key) {
+    assert(sl);
+    size_t lo = rank_of_key(sl, min_key, false);
+    size_t hi = rank_of_key(sl, max_key, true);
+    return hi > lo ? hi - lo : 0;
+}
+
+bool skiplist_at_index(struct skiplist *sl, size_t idx,
+        void **key, void **value) {
+    assert(sl);
+    if (idx >= sl->count) { return false; }
+    struct skiplist_node *cur = sl->head;
+    size_t target = idx + 1;    /* 1-based level-0 rank */
+    size_t rank = 0;
+
+    for (int lvl = sl->head->h - 1; lvl >= 0; lvl--) {
+        while (!IS_SENTINEL(cur->next[lvl]) &&
+            rank + NODE_WIDTHS(cur)[lvl] <= target) {
+            rank += NODE_WIDTHS(cur)[lvl];
+            cur = cur->next[lvl];
+        }
+        if (rank == target) { break; }
+    }
+    assert(rank == target);
+    assert(!IS_SENTINEL(cur));
+    if (key) { *key = NODE_KEY(cur); }
+    if (value) { *value = cur->v; }
+    return true;
+}
+#endif
+
 static void walk_and_apply(struct skiplist_node *cur,
         skiplist_iter_cb *cb, void *udata) {
     while (!IS_SENTINEL(cur)) {
         enum skiplist_iter_res res;
-        res = cb(cur->k, cur->v, udata);
+        res = cb(NODE_KEY(cur), cur->v, udata);
         if (res != SKIPLIST_ITER_CONTINUE) { break; }
-        cur = cur->next[0];
+        cur = SL_LOAD_ACQ(&cur->next[0]);
     }
 }
 
 void skiplist_iter(struct skiplist *sl, skiplist_iter_cb *cb, void *udata) {
     assert(sl);
     assert(cb);
-    walk_and_apply(sl->head->next[0], cb, udata);
+    walk_and_apply(SL_LOAD_ACQ(&SL_LOAD_ACQ(&sl->head)->next[0]), cb, udata);
 }
 
 void skiplist_iter_from(struct skiplist *sl, void *key,
@@ -484,19 +1854,480 @@ void skiplist_iter_from(struct skiplist *sl, void *key,
     walk_and_apply(cur, cb, udata);
 }
 
+void skiplist_iter_from_ex(struct skiplist *sl, void *probe,
+        skiplist_probe_cmp_cb *pcmp, skiplist_iter_cb *cb, void *udata) {
+    assert(sl);
+    assert(pcmp);
+    assert(cb);
+    struct skiplist_node *cur = get_first_eq_node_ex(sl, probe, pcmp);
+    if (cur == NULL) { return; }
+    walk_and_apply(cur, cb, udata);
+}
+
+#if SKIPLIST_BACK_POINTERS
+void skiplist_iter_reverse(struct skiplist *sl, skiplist_iter_cb *cb,
+        void *udata) {
+    assert(sl);
+    assert(cb);
+    /* One descent to the last pair, then walk the back-pointers, so
+     * the first N pairs cost O(log n + N). */
+    struct skiplist_node *head = sl->head;
+    struct skiplist_node *cur = head;
+    int lvl = head->h - 1;
+    do {
+        struct skiplist_node *next = cur->next[lvl];
+        if (IS_SENTINEL(next)) {
+            lvl--;
+        } else {
+            cur = next;
+        }
+    } while (lvl >= 0);
+
+    while (cur != head) {       /* CUR == HEAD when SL is empty */
+        if (cb(NODE_KEY(cur), cur->v, udata) != SKIPLIST_ITER_CONTINUE) {
+            return;
+        }
+        cur = cur->prev ? cur->prev : head;
+    }
+}
+#endif
+
+struct skiplist_cursor {
+    struct skiplist *sl;
+    /* Current position; &SENTINEL when off the end. */
+    struct skiplist_node *pos;
+};
+
+struct skiplist_cursor *skiplist_cursor_open(struct skiplist *sl) {
+    assert(sl);
+    struct skiplist_cursor *c = sl->alloc(NULL, 0,
+        sizeof(*c), sl->alloc_udata);
+    if (c == NULL) { return NULL; }
+    c->sl = sl;
+    c->pos = SL_LOAD_ACQ(&SL_LOAD_ACQ(&sl->head)->next[0]);
+    return c;
+}
+
+bool skiplist_cursor_seek(struct skiplist_cursor *c, void *key) {
+    assert(c);
+    c->pos = get_first_geq_node(c->sl, key);
+    return !IS_SENTINEL(c->pos);
+}
+
+bool skiplist_cursor_get(struct skiplist_cursor *c,
+        void **key, void **value) {
+    assert(c);
+    if (IS_SENTINEL(c->pos)) { return false; }
+    if (key) { *key = NODE_KEY(c->pos); }
+    if (value) { *value = c->pos->v; }
+    return true;
+}
+
+bool skiplist_cursor_next(struct skiplist_cursor *c) {
+    assert(c);
+    if (IS_SENTINEL(c->pos)) { return false; }
+    c->pos = c->pos->next[0];
+    return !IS_SENTINEL(c->pos);
+}
+
+bool skiplist_cursor_prev(struct skiplist_cursor *c) {
+    assert(c);
+#if SKIPLIST_BACK_POINTERS
+    /* On a pair, stepping back is one pointer chase; off the end,
+     * fall through to the last-pair descent below. */
+    if (!IS_SENTINEL(c->pos)) {
+        if (c->pos->prev == NULL) { return false; }
+        c->pos = c->pos->prev;
+        return true;
+    }
+#endif
+    struct skiplist *sl = c->sl;
+    struct skiplist_node *head = SL_LOAD_ACQ(&sl->head);
+    struct skiplist_node *cur = head;
+
+    if (IS_SENTINEL(c->pos)) {  /* off the end -> last pair */
+        int lvl = head->h - 1;
+        do {
+            struct skiplist_node *next = SL_LOAD_ACQ(&cur->next[lvl]);
+            if (IS_SENTINEL(next)) {
+                lvl--;
+            } else {
+                cur = next;
+            }
+        } while (lvl >= 0);
+        if (cur == head) { return false; }  /* empty */
+        c->pos = cur;
+        return true;
+    }
+
+    /* Descend to the first node with key >= pos's key, then walk
+     * forward on the bottom level until the next node is pos itself;
+     * with duplicate keys this may walk over the other duplicates. */
+    int lvl = head->h - 1;
+    do {
+        struct skiplist_node *next = SL_LOAD_ACQ(&cur->next[lvl]);
+        int res = IS_SENTINEL(next) ? 1 : SL_CMP(sl, NODE_KEY(next), NODE_KEY(c->pos));
+        if (res < 0) {
+            cur = next;
+        } else {
+            lvl--;
+        }
+    } while (lvl >= 0);
+
+    while (SL_LOAD_ACQ(&cur->next[0]) != c->pos) {
+        cur = SL_LOAD_ACQ(&cur->next[0]);
+        assert(!IS_SENTINEL(cur));
+    }
+    if (cur == head) { return false; }  /* already on the first pair */
+    c->pos = cur;
+    return true;
+}
+
+void skiplist_cursor_close(struct skiplist_cursor *c) {
+    assert(c);
+    struct skiplist *sl = c->sl;
+    sl->alloc(c, sizeof(*c), 0, sl->alloc_udata);
+}
+
+unsigned skiplist_epoch_enter(struct skiplist *sl) {
+    assert(sl);
+    sl->deferred = true;        /* from now on, defer node frees */
+    for (;;) {
+        unsigned e = SL_LOAD_SC(&sl->epoch);
+        SL_FADD_SC(&sl->epoch_readers[e & 1], 1);
+        if (SL_LOAD_SC(&sl->epoch) == e) { return e; }
+        /* The epoch advanced while entering; move to the new one so
+         * the writer doesn't wait on us under the old epoch. */
+        SL_FSUB_SC(&sl->epoch_readers[e & 1], 1);
+    }
+}
+
+void skiplist_epoch_leave(struct skiplist *sl, unsigned epoch) {
+    assert(sl);
+    SL_FSUB_SC(&sl->epoch_readers[epoch & 1], 1);
+}
+
+size_t skiplist_reclaim(struct skiplist *sl) {
+    assert(sl);
+    unsigned e = SL_LOAD_SC(&sl->epoch);
+
+    /* Nodes retired during epoch e-1 live in limbo[(e+1) & 1]. They
+     * can only be freed once every reader that entered at epoch e-1
+     * (or earlier) has left; readers that entered at epoch e saw the
+     * unlinks and never reached them. */
+    if (SL_LOAD_SC(&sl->epoch_readers[(e + 1) & 1]) != 0) {
+        return 0;               /* old readers still active */
+    }
+
+    size_t ct = 0;
+    struct skiplist_limbo_node *ln;
+    do {                        /* concurrent writers may still push */
+        ln = SL_LOAD_SC(&sl->limbo[(e + 1) & 1]);
+    } while (!SL_CAS(&sl->limbo[(e + 1) & 1], ln, NULL));
+    while (ln) {
+        struct skiplist_limbo_node *next = ln->next;
+        node_free(sl, ln->n);
+        sl->alloc(ln, sizeof(*ln), 0, sl->alloc_udata);
+        ln = next;
+        ct++;
+    }
+    SL_STORE_SC(&sl->epoch, e + 1);
+    return ct;
+}
+
+/* Free everything on both limbo lists. Only safe once no readers
+ * remain, e.g. from skiplist_free. */
+static void drain_limbo(struct skiplist *sl) {
+    for (int i = 0; i < 2; i++) {
+        struct skiplist_limbo_node *ln = sl->limbo[i];
+        sl->limbo[i] = NULL;
+        while (ln) {
+            struct skiplist_limbo_node *next = ln->next;
+            node_free(sl, ln->n);
+            sl->alloc(ln, sizeof(*ln), 0, sl->alloc_udata);
+            ln = next;
+        }
+    }
+}
+
+/* Lock-free multi-writer variant (see skiplist.h).
+ *
+ * Logical deletion, Harris/Fraser style: the low bit of a node's own
+ * forward pointers marks it as deleted. Marked nodes are physically
+ * spliced out by the next concurrent_search that passes them, and
+ * always go through the epoch limbo lists before being freed. */
+#define PTR_MARKED(p) (((uintptr_t)(p)) & 1)
+#define PTR_MARK(p)                                                     \
+    ((struct skiplist_node *)(((uintptr_t)(p)) | 1))
+#define PTR_UNMARK(p)                                                   \
+    ((struct skiplist_node *)(((uintptr_t)(p)) & ~(uintptr_t)1))
+
+struct skiplist *skiplist_new_concurrent(skiplist_cmp_cb *cmp,
+        skiplist_alloc_cb *alloc, void *alloc_udata) {
+    struct skiplist *sl = skiplist_new(cmp, alloc, alloc_udata);
+    if (sl == NULL) { return NULL; }
+
+    /* Replace the single-level head with a full-height one: the head
+     * cannot be swapped out from under concurrent searches the way
+     * grow_head does for the single-writer case. */
+    struct skiplist_node *head = node_alloc(sl,
+        SKIPLIST_MAX_HEIGHT, NULL, NULL);
+    if (head == NULL) {
+        skiplist_free(sl, NULL, NULL);
+        return NULL;
+    }
+    node_free(sl, sl->head);
+    sl->head = head;
+    sl->concurrent = true;
+    sl->deferred = true;        /* unlinked nodes always go to limbo */
+    return sl;
+}
+
+/* Find KEY's predecessor and successor at every level, physically
+ * unlinking any marked nodes passed along the way. On return,
+ * preds[lvl]->next[lvl] == succs[lvl] held at some point during the
+ * call, with both unmarked; succs[0] is the first node >= KEY. */
+static void concurrent_search(struct skiplist *sl, void *key,
+        struct skiplist_node **preds, struct skiplist_node **succs) {
+retry:;
+    struct skiplist_node *pred = sl->head;
+    for (int lvl = SKIPLIST_MAX_HEIGHT - 1; lvl >= 0; lvl--) {
+        struct skiplist_node *cur = PTR_UNMARK(SL_LOAD_SC(&pred->next[lvl]));
+        for (;;) {
+            if (IS_SENTINEL(cur)) { break; }
+            struct skiplist_node *next = SL_LOAD_SC(&cur->next[lvl]);
+            if (PTR_MARKED(next)) {
+                /* CUR is logically deleted; splice it out. If the
+                 * CAS fails another thread moved pred->next[lvl],
+                 * so start over. */
+                if (!SL_CAS(&pred->next[lvl], cur, PTR_UNMARK(next))) {
+                    goto retry;
+                }
+                cur = PTR_UNMARK(next);
+                continue;
+            }
+            if (SL_CMP(sl, NODE_KEY(cur), key) < 0) {
+                pred = cur;
+                cur = next;
+            } else {
+                break;
+            }
+        }
+        preds[lvl] = pred;
+        succs[lvl] = cur;
+    }
+}
+
+bool skiplist_concurrent_add(struct skiplist *sl, void *key, void *value) {
+    assert(sl);
+    assert(sl->concurrent);
+    struct skiplist_node *preds[SKIPLIST_MAX_HEIGHT];
+    struct skiplist_node *succs[SKIPLIST_MAX_HEIGHT];
+    struct skiplist_node *nn = NULL;
+    uint8_t new_height = SKIPLIST_GEN_HEIGHT();
+    assert(new_height <= SKIPLIST_MAX_HEIGHT);
+    if (sl->adaptive) {
+        /* Racing inserts can make the count read stale, but a cap
+         * one doubling behind only trims one level of headroom. */
+        uint8_t cap = height_cap(SL_LOAD_ACQ(&sl->count));
+        if (new_height > cap) { new_height = cap; }
+    }
+
+    for (;;) {
+        concurrent_search(sl, key, preds, succs);
+        if (!IS_SENTINEL(succs[0]) &&
+            0 == SL_CMP(sl, NODE_KEY(succs[0]), key)) {
+            if (nn) { node_free(sl, nn); }      /* never linked */
+            return false;       /* duplicate keys are rejected */
+        }
+        if (nn == NULL) {
+            nn = node_alloc(sl, new_height, key, value);
+            if (nn == NULL) { return false; }
+        }
+        DO(nn->h, nn->next[i] = succs[i]);
+        /* Linking level 0 makes the insert official. */
+        if (SL_CAS(&preds[0]->next[0], succs[0], nn)) { break; }
+    }
+    SL_FADD_SC(&sl->count, 1);
+
+    /* Link the upper levels. If the new node gets deleted while we
+     * work, its pointers get marked and we abandon the rest: the
+     * deleter's unlinking search only needs the levels we linked. */
+    for (int lvl = 1; lvl < nn->h; lvl++) {
+        for (;;) {
+            struct skiplist_node *next = SL_LOAD_SC(&nn->next[lvl]);
+            if (PTR_MARKED(next)) { return true; }
+            if (next != succs[lvl] &&
+                !SL_CAS(&nn->next[lvl], next, succs[lvl])) {
+                return true;    /* marked in the meantime */
+            }
+            if (SL_CAS(&preds[lvl]->next[lvl], succs[lvl], nn)) {
+                /* A deleter may have marked every level and
+                 * physically unlinked the node in the window between
+                 * the mark check above and this CAS, which would
+                 * have just re-linked a retired node. Re-validate
+                 * and, if marked, search again to unlink it before
+                 * returning. */
+                if (PTR_MARKED(SL_LOAD_SC(&nn->next[lvl]))) {
+                    concurrent_search(sl, key, preds, succs);
+                    return true;
+                }
+                break;
+            }
+            /* The neighborhood changed under us; look it up again. */
+            concurrent_search(sl, key, preds, succs);
+        }
+    }
+    return true;
+}
+
+bool skiplist_concurrent_delete(struct skiplist *sl,
+        void *key, void **value) {
+    assert(sl);
+    assert(sl->concurrent);
+    struct skiplist_node *preds[SKIPLIST_MAX_HEIGHT];
+    struct skiplist_node *succs[SKIPLIST_MAX_HEIGHT];
+
+    for (;;) {
+        concurrent_search(sl, key, preds, succs);
+        struct skiplist_node *victim = succs[0];
+        if (IS_SENTINEL(victim) ||
+            0 != SL_CMP(sl, NODE_KEY(victim), key)) {
+            return false;
+        }
+
+        /* Mark the victim's forward pointers from the top down;
+         * marking level 0 makes the delete official. */
+        for (int lvl = victim->h - 1; lvl >= 1; lvl--) {
+            struct skiplist_node *next = SL_LOAD_SC(&victim->next[lvl]);
+            while (!PTR_MARKED(next)) {
+                if (SL_CAS(&victim->next[lvl], next, PTR_MARK(next))) {
+                    break;
+                }
+                next = SL_LOAD_SC(&victim->next[lvl]);
+            }
+        }
+        struct skiplist_node *next = SL_LOAD_SC(&victim->next[0]);
+        while (!PTR_MARKED(next)) {
+            if (SL_CAS(&victim->next[0], next, PTR_MARK(next))) {
+                if (value) { *value = victim->v; }
+                SL_FSUB_SC(&sl->count, 1);
+                /* Physically unlink before retiring. Keys are unique,
+                 * so this search passes (and splices out) the victim
+                 * at every level where it is still linked. */
+                concurrent_search(sl, key, preds, succs);
+                node_retire(sl, victim);
+                return true;
+            }
+            next = SL_LOAD_SC(&victim->next[0]);
+        }
+        /* Another thread won the race to delete this node; the key
+         * may have been re-added since, so look it up again. */
+    }
+}
+
+bool skiplist_concurrent_get(struct skiplist *sl, void *key, void **value) {
+    assert(sl);
+    assert(sl->concurrent);
+
+    /* Read-only descent: marked nodes are skipped, not spliced out,
+     * so readers never write to the list. */
+    struct skiplist_node *pred = sl->head;
+    struct skiplist_node *cur = &SENTINEL;
+    for (int lvl = SKIPLIST_MAX_HEIGHT - 1; lvl >= 0; lvl--) {
+        cur = PTR_UNMARK(SL_LOAD_SC(&pred->next[lvl]));
+        for (;;) {
+            if (IS_SENTINEL(cur)) { break; }
+            struct skiplist_node *next = SL_LOAD_SC(&cur->next[lvl]);
+            if (PTR_MARKED(next)) {
+                cur = PTR_UNMARK(next);
+                continue;
+            }
+            if (SL_CMP(sl, NODE_KEY(cur), key) < 0) {
+                pred = cur;
+                cur = next;
+            } else {
+                break;
+            }
+        }
+    }
+    if (IS_SENTINEL(cur) || 0 != SL_CMP(sl, NODE_KEY(cur), key)) {
+        return false;
+    }
+    if (value) { *value = cur->v; }
+    return true;
+}
+
+bool skiplist_concurrent_member(struct skiplist *sl, void *key) {
+    return skiplist_concurrent_get(sl, key, NULL);
+}
+
 size_t skiplist_clear(struct skiplist *sl,
         skiplist_free_cb *cb, void *udata) {
     assert(sl);
+    RESOLVE_FREE_CB(sl, cb, udata);
     struct skiplist_node *cur = sl->head->next[0];
     size_t ct = 0;
     while (!IS_SENTINEL(cur)) {
         struct skiplist_node *doomed = cur;
-        if (cb) { cb(doomed->k, doomed->v, udata); }
+        if (cb) { cb(NODE_KEY(doomed), doomed->v, udata); }
         cur = doomed->next[0];
-        node_free(sl, doomed);
+        node_retire(sl, doomed);
         ct++;
     }
-    DO(sl->head->h, sl->head->next[i] = &SENTINEL);
+    DO(sl->head->h, SL_STORE_REL(&sl->head->next[i], &SENTINEL));
+#if SKIPLIST_WIDTHS
+    DO(sl->head->h, NODE_WIDTHS(sl->head)[i] = 1);
+#endif
+    SL_STORE_REL(&sl->count, 0);
+    return ct;
+}
+
+/* A detached set of nodes: the level-0 chain that used to belong to
+ * SL, still terminated by the sentinel. Freed by its final
+ * skiplist_detach_drain call. */
+struct skiplist_detached {
+    struct skiplist *sl;
+    struct skiplist_node *cur;
+};
+
+struct skiplist_detached *skiplist_detach(struct skiplist *sl) {
+    assert(sl);
+    struct skiplist_detached *d = sl->alloc(NULL, 0,
+        sizeof(*d), sl->alloc_udata);
+    if (d == NULL) { return NULL; }
+    d->sl = sl;
+    d->cur = sl->head->next[0];
+
+    /* Same head reset as skiplist_clear, without the O(n) walk:
+     * the nodes now belong to the handle. */
+    DO(sl->head->h, SL_STORE_REL(&sl->head->next[i], &SENTINEL));
+#if SKIPLIST_WIDTHS
+    DO(sl->head->h, NODE_WIDTHS(sl->head)[i] = 1);
+#endif
+    SL_STORE_REL(&sl->count, 0);
+    return d;
+}
+
+size_t skiplist_detach_drain(struct skiplist_detached *d,
+        size_t max_nodes, skiplist_free_cb *cb, void *udata) {
+    assert(d);
+    RESOLVE_FREE_CB(d->sl, cb, udata);
+    struct skiplist_node *cur = d->cur;
+    size_t ct = 0;
+    while (!IS_SENTINEL(cur) && (max_nodes == 0 || ct < max_nodes)) {
+        struct skiplist_node *doomed = cur;
+        cur = cur->next[0];
+        if (cb) { cb(NODE_KEY(doomed), doomed->v, udata); }
+        node_free(d->sl, doomed);
+        ct++;
+    }
+    d->cur = cur;
+
+    if (IS_SENTINEL(cur) && (max_nodes == 0 || ct < max_nodes)) {
+        struct skiplist *sl = d->sl;
+        sl->alloc(d, sizeof(*d), 0, sl->alloc_udata);
+    }
     return ct;
 }
 
@@ -504,6 +2335,7 @@ size_t skiplist_free(struct skiplist *sl,
         skiplist_free_cb *cb, void *udata) {
     assert(sl);
     size_t ct = skiplist_clear(sl, cb, udata);
+    drain_limbo(sl);
     node_free(sl, sl->head);
     sl->alloc(sl, sizeof(*sl), 0, sl->alloc_udata);
     return ct;
@@ -533,7 +2365,7 @@ void skiplist_debug(struct skiplist *sl, FILE *f,
             if (f) {
                 fprintf(f, " -> %p(%d%s",
                     (void *)n, n->h, cb == NULL ? "" : ":");
-                if (cb) { cb(f, n->k, n->v, udata); }
+                if (cb) { cb(f, NODE_KEY(n), n->v, udata); }
                 fprintf(f, ")");
             }
 
@@ -556,5 +2388,56 @@ void skiplist_debug(struct skiplist *sl, FILE *f,
             if (counts[i] > 0)
                 fprintf(f, "-- Count @ %d: %d\n", i, counts[i]));
     }
+
+#if SKIPLIST_WIDTHS
+    /* Every width must equal the number of level-0 links its forward
+     * pointer actually covers, and each level must sum to count + 1
+     * (the final step to the sentinel). */
+    for (int i = 0; i < max_lvl; i++) {
+        size_t total = 0;
+        for (n = head; !IS_SENTINEL(n); n = n->next[i]) {
+            size_t steps = 0;
+            for (struct skiplist_node *z = n; z != n->next[i];
+                 z = z->next[0]) {
+                steps++;
+            }
+            assert(NODE_WIDTHS(n)[i] == steps);
+            total += NODE_WIDTHS(n)[i];
+        }
+        assert(total == sl->count + 1);
+    }
+#endif
+
+#if SKIPLIST_BACK_POINTERS
+    /* The bottom level is doubly linked: every node points back at
+     * its level-0 predecessor, with NULL standing in for the head. */
+    struct skiplist_node *bp = head;
+    for (n = head->next[0]; !IS_SENTINEL(n); n = n->next[0]) {
+        assert(n->prev == (bp == head ? NULL : bp));
+        bp = n;
+    }
+#endif
+}
+#endif
+
+#if SKIPLIST_STATS
+void skiplist_stats(struct skiplist *sl, struct skiplist_stats *out) {
+    assert(sl);
+    assert(out);
+    memset(out, 0, sizeof(*out));
+    out->bytes = sl->stat_bytes;
+    out->head_grows = sl->stat_head_grows;
+    out->searches = sl->stat_searches;
+    out->comparisons = sl->stat_cmps;
+
+    /* The height histogram is tallied on demand with one O(n) walk
+     * rather than maintained incrementally; callers poll this rarely
+     * compared to how often nodes come and go. */
+    for (struct skiplist_node *n = sl->head->next[0];
+         !IS_SENTINEL(n); n = n->next[0]) {
+        assert(n->h >= 1);
+        assert(n->h <= SKIPLIST_MAX_HEIGHT);
+        out->nodes_at_height[n->h - 1]++;
+    }
 }
 #endif
@@ -61,6 +61,42 @@ struct skiplist *skiplist_new(skiplist_cmp_cb *cmp,
 /* Set the random seed used when randomly constructing skiplists. */
 void skiplist_set_seed(unsigned seed);
 
+/* Give SL its own height-generation PRNG (xorshift64*), seeded with
+ * SEED, instead of the global generator. The global default calls
+ * random(), which takes a process-wide lock in some libcs and
+ * serializes threads inserting into otherwise-independent lists; a
+ * locally-seeded list touches only its own word of state and draws
+ * each height with a single count-trailing-zeros. Also makes the
+ * list's structure deterministic for a given seed and insertion
+ * sequence. Not used by the skiplist_concurrent_* operations, which
+ * stay on the global generator. */
+void skiplist_set_seed_local(struct skiplist *sl, uint64_t seed);
+
+/* Cap generated node heights near log2(count) + 1, raising the cap
+ * as the list grows, instead of always drawing from the full
+ * SKIPLIST_MAX_HEIGHT range. A small list gains nothing from a tall
+ * node -- searches still descend from the head -- but pays for its
+ * pointer array, which adds up across many small lists. The cap
+ * tracks the expected height of the tallest node, so large lists
+ * are unaffected. Off by default. */
+void skiplist_set_adaptive_height(struct skiplist *sl, bool adaptive);
+
+#if SKIPLIST_FINGERPRINT
+/* Key fingerprint callback: a small integer summary of a key, for
+ * example its first 8 bytes packed big-endian. It must be monotonic
+ * in key order: if cmp(a, b) < 0 then prefix(a) <= prefix(b). */
+typedef uint64_t skiplist_prefix_cb(void *key);
+
+/* Set the fingerprint callback for an empty skiplist. Each node then
+ * stores its key's fingerprint inline, and searches compare
+ * fingerprints first, only falling back to the cmp callback when
+ * they tie. With expensive comparisons (long composite keys), most
+ * of a search becomes integer compares on data already in cache.
+ * Must be called before any pairs are added. */
+void skiplist_set_prefix_cb(struct skiplist *sl,
+    skiplist_prefix_cb *prefix);
+#endif
+
 /* Randomly generate the height for the next level.
  * Should return between 1 and SKIPLIST_MAX_HEIGHT, inclusive.
  * Returning an illegal height is a checked error.
@@ -90,6 +126,150 @@ bool skiplist_add(struct skiplist *sl, void *key, void *value);
 bool skiplist_set(struct skiplist *sl,
     void *key, void *value, void **old);
 
+/* Callback for skiplist_update. *VALUE is KEY's value slot: when
+ * the key is PRESENT it holds the current value, and assigning to
+ * *VALUE replaces it in place. When the key is absent *VALUE starts
+ * as NULL; set it and return true to insert the pair, or return
+ * false to leave the skiplist unchanged. The return value is
+ * ignored for a present key. */
+typedef bool skiplist_update_cb(void *key, void **value,
+    bool present, void *udata);
+
+/* Update the value for KEY in place with a single search, creating
+ * the pair if the callback asks for it -- an upsert. A counter
+ * bump through here costs one traversal where skiplist_get +
+ * skiplist_set costs two. With duplicate keys, the first match is
+ * updated. Returns whether the skiplist contains the key
+ * afterward (false when an absent key was declined by the
+ * callback, or inserting its pair failed to allocate). */
+bool skiplist_update(struct skiplist *sl, void *key,
+    skiplist_update_cb *cb, void *udata);
+
+/* A search finger caches the path from the most recent operation,
+ * so the next operation costs O(log d) in the distance d between
+ * the two keys rather than O(log n) from the head. When successive
+ * keys are close -- e.g. nearly-sorted timestamp ingest -- adds
+ * become effectively O(1).
+ *
+ * A finger belongs to one caller and is invalidated by any
+ * modification to the skiplist that does not go through it;
+ * using it after such a modification is undefined. Any number of
+ * fingers can be open for read-only use. */
+struct skiplist_finger;
+
+/* Create a search finger for SL, initially positioned at the head.
+ * Returns NULL on error. */
+struct skiplist_finger *skiplist_finger_new(struct skiplist *sl);
+
+/* As skiplist_add/skiplist_get, but searching from the finger's
+ * current position and leaving the finger at KEY. */
+bool skiplist_add_at(struct skiplist_finger *f, void *key, void *value);
+bool skiplist_get_at(struct skiplist_finger *f, void *key, void **value);
+
+/* Free the finger. The skiplist is unaffected. */
+void skiplist_finger_free(struct skiplist_finger *f);
+
+/* Batch operations: sort the batch internally and walk the list
+ * once with a finger, so the top levels of each search are
+ * amortized across the batch. With batches of a few hundred
+ * operations this is several times faster than looping the
+ * single-key calls.
+ *
+ * skiplist_add_batch adds KEYS[i]/VALUES[i] for each of the COUNT
+ * pairs (all values NULL if VALUES is NULL) and returns how many
+ * were added; on allocation failure it stops early, leaving the
+ * pairs added so far in place.
+ *
+ * skiplist_get_batch looks up each key: if VALUES is non-NULL,
+ * VALUES[i] is set to the value for KEYS[i], or NULL if absent.
+ * Returns how many keys were found.
+ *
+ * skiplist_delete_batch deletes (one match of) each key, reporting
+ * the old values through VALUES the same way; a key that appears
+ * twice in the batch deletes two duplicates. Returns how many keys
+ * were deleted. */
+size_t skiplist_add_batch(struct skiplist *sl, void **keys,
+    void **values, size_t count);
+size_t skiplist_get_batch(struct skiplist *sl, void **keys,
+    void **values, size_t count);
+size_t skiplist_delete_batch(struct skiplist *sl, void **keys,
+    void **values, size_t count);
+
+/* Bulk-load COUNT key/value pairs that are already sorted
+ * (nondecreasing, according to the cmp callback). Every key must also
+ * compare >= the last key currently in the skiplist, so this can only
+ * append. The levels are constructed left to right, so loading N pairs
+ * is O(N) rather than the O(N log N) of repeated skiplist_add calls.
+ * VALUES may be NULL, in which case all values are NULL.
+ *
+ * Returns whether all pairs were added. On out-of-order input or
+ * allocation failure, loading stops and the pairs added so far
+ * remain in the skiplist. */
+bool skiplist_load_sorted(struct skiplist *sl,
+    void **keys, void **values, size_t count);
+
+/* Merge SRC into DST by stealing SRC's nodes: one pass over both
+ * bottom levels, O(n + m) regardless of how the keys interleave,
+ * instead of the O(m log n) of iterating SRC and re-adding. On equal
+ * keys DST's pairs sort first. Both lists must use the same cmp and
+ * alloc configuration, since DST will eventually free SRC's nodes.
+ * SRC is left empty but valid -- reusable, and still to be freed by
+ * the caller. Returns false (changing nothing) only if growing DST's
+ * head fails. */
+bool skiplist_merge(struct skiplist *dst, struct skiplist *src);
+
+/* Split SL at KEY: every pair with a key >= KEY moves to a newly
+ * created skiplist (same cmp and alloc), which is returned; SL keeps
+ * the rest. The forward pointers are severed at each level, so no
+ * pairs are copied: O(log n), plus an O(moved) count walk unless
+ * SKIPLIST_WIDTHS is enabled. Returns NULL (changing nothing) on
+ * allocation failure. */
+struct skiplist *skiplist_split(struct skiplist *sl, void *key);
+
+/* Serialization
+ * =============
+ *
+ * skiplist_serialize streams the pairs in key order, each preceded by
+ * its node's height, so skiplist_deserialize can rebuild every level
+ * in a single O(n) pass: no searches and no height generation, just
+ * appends (as in skiplist_load_sorted). Key and value encoding is
+ * delegated to callbacks, and the stream's internal fields use the
+ * machine's native byte order, so portability across architectures is
+ * up to the encoding callbacks and the user. */
+
+/* Write LEN bytes from BUF to the output stream.
+ * Return false to abort. */
+typedef bool skiplist_write_cb(const void *buf, size_t len, void *udata);
+
+/* Read exactly LEN bytes from the input stream into BUF.
+ * Return false to abort. */
+typedef bool skiplist_read_cb(void *buf, size_t len, void *udata);
+
+/* Encode KEY and VALUE by calling WRITE (passing it UDATA) one or
+ * more times. Return false to abort. */
+typedef bool skiplist_encode_cb(void *key, void *value,
+    skiplist_write_cb *write, void *udata);
+
+/* Decode one key and value by calling READ (passing it UDATA), and
+ * return them in *KEY and *VALUE. Return false to abort. */
+typedef bool skiplist_decode_cb(void **key, void **value,
+    skiplist_read_cb *read, void *udata);
+
+/* Write the whole skiplist to WRITE as a stream.
+ * Returns false if any callback failed, in which case the output
+ * written so far is incomplete. */
+bool skiplist_serialize(struct skiplist *sl, skiplist_write_cb *write,
+    skiplist_encode_cb *encode, void *udata);
+
+/* Rebuild a skiplist from a stream produced by skiplist_serialize.
+ * cmp, alloc and alloc_udata are as in skiplist_new.
+ * Returns NULL on a malformed stream, out-of-order keys, or a failed
+ * callback; keys and values decoded before such a failure are not
+ * freed. */
+struct skiplist *skiplist_deserialize(skiplist_read_cb *read,
+    skiplist_decode_cb *decode, void *udata, skiplist_cmp_cb *cmp,
+    skiplist_alloc_cb *alloc, void *alloc_udata);
+
 /* Get the value associated with KEY. If the key is found and VALUE is
  * non-NULL, it will be written into *VALUE.
  * Returns whether the key was found. */
@@ -98,6 +278,58 @@ bool skiplist_get(struct skiplist *sl, void *key, void **value);
 /* Does the skiplist contain KEY? */
 bool skiplist_member(struct skiplist *sl, void *key);
 
+/* Look up COUNT point queries at once: VALUES[i] is set to the value
+ * for KEYS[i], or NULL when it is absent. Returns the number of keys
+ * found.
+ *
+ * A single search is a serial chain of dependent loads -- each
+ * next-node load must land before the comparison picks the next one
+ * -- so skiplist_get_many interleaves several independent searches
+ * and prefetches each one's next node while the others compare,
+ * overlapping the cache misses. On large lists this is several times
+ * faster than calling skiplist_get in a loop. The keys need not be
+ * sorted; for sorted (or sortable) batches skiplist_get_batch
+ * exploits locality instead. */
+size_t skiplist_get_many(struct skiplist *sl, void **keys,
+    void **values, size_t count);
+
+/* Get the pair with the first key >= KEY (ceiling) or the last
+ * key <= KEY (floor), whether or not KEY itself is present --
+ * O(log n), unlike scanning with skiplist_iter and remembering the
+ * previous pair. If a pair is found and OUT_KEY/OUT_VALUE are
+ * non-NULL, its key and value are written through them.
+ * Returns whether such a pair exists. */
+bool skiplist_ceiling(struct skiplist *sl, void *key,
+    void **out_key, void **out_value);
+bool skiplist_floor(struct skiplist *sl, void *key,
+    void **out_key, void **out_value);
+
+/* Probe comparator for the *_ex lookups below: called as
+ * PCMP(probe, key), where PROBE is the caller's search argument and
+ * KEY is a key stored in the skiplist, returning <0, 0 or >0 as with
+ * skiplist_cmp_cb. The probe need not be a key of the list's own
+ * type -- e.g. a borrowed (pointer, length) view into a network
+ * buffer can be compared against owned, NUL-terminated string keys
+ * -- so a lookup need not allocate or copy a temporary key just to
+ * search with it. The ordering PCMP induces must agree with the
+ * list's own comparator, or the search will descend into the wrong
+ * region. */
+typedef int skiplist_probe_cmp_cb(void *probe, void *key);
+
+/* As skiplist_get / skiplist_member / skiplist_ceiling /
+ * skiplist_floor, but comparing stored keys against PROBE with PCMP
+ * instead of a materialized key of the list's own type. Key-prefix
+ * fingerprints (SKIPLIST_FINGERPRINT) cannot be consulted for a
+ * probe, so every step pays a full comparison. */
+bool skiplist_get_ex(struct skiplist *sl, void *probe,
+    skiplist_probe_cmp_cb *pcmp, void **value);
+bool skiplist_member_ex(struct skiplist *sl, void *probe,
+    skiplist_probe_cmp_cb *pcmp);
+bool skiplist_ceiling_ex(struct skiplist *sl, void *probe,
+    skiplist_probe_cmp_cb *pcmp, void **out_key, void **out_value);
+bool skiplist_floor_ex(struct skiplist *sl, void *probe,
+    skiplist_probe_cmp_cb *pcmp, void **out_key, void **out_value);
+
 /* Delete an association for KEY in the skiplist.
  * If found and VALUE is non-NULL, the old value will be
  * written to *VALUE.
@@ -110,11 +342,36 @@ bool skiplist_delete(struct skiplist *sl, void *key, void **value);
 /* Callback when freeing keys and/or values contained by the skiplist. */
 typedef void skiplist_free_cb(void *key, void *value, void *udata);
 
-/* Delete all associations for KEY in the skiplist. The callback is
- * called for each key/value pair, and cannot be NULL. */
+/* Register a destructor for the skiplist's pairs: the destructive
+ * operations taking a skiplist_free_cb (skiplist_clear,
+ * skiplist_free, skiplist_delete_all, skiplist_delete_range,
+ * skiplist_detach_drain) fall back to CB when called with a NULL
+ * callback, so it only needs threading through once instead of at
+ * every call site. Passing NULL unregisters it. Pairs removed by
+ * skiplist_delete and skiplist_pop_first/last are returned to the
+ * caller, not destroyed, so the destructor does not apply there. */
+void skiplist_set_destructor(struct skiplist *sl,
+    skiplist_free_cb *cb, void *udata);
+
+/* Delete all associations for KEY in the skiplist. The callback
+ * (optional) is called for each key/value pair; with a NULL callback
+ * the registered destructor (if any) is used, and with neither the
+ * pairs are simply dropped, without a per-pair indirect call. */
 void skiplist_delete_all(struct skiplist *sl, void *key,
     skiplist_free_cb *cb, void *udata);
 
+/* Delete every association whose key is >= MIN_KEY and <= MAX_KEY.
+ * The boundaries are found with a single search, the whole span is
+ * unlinked at once, and the doomed nodes are freed in a linear walk,
+ * so this is O(log n + k) for k deleted pairs rather than the
+ * O(k log n) of calling skiplist_delete in a loop. The callback
+ * (optional, falling back to the registered destructor) is called
+ * for each deleted key/value pair.
+ * Returns the number of pairs deleted. */
+size_t skiplist_delete_range(struct skiplist *sl,
+    void *min_key, void *max_key,
+    skiplist_free_cb *cb, void *udata);
+
 /* Get the first or last pair from the skiplist.
  * If key or value are non-NULL, the pair is returned in them.
  * Passing in a NULL key is legal, it will be ignored.
@@ -135,6 +392,19 @@ size_t skiplist_count(struct skiplist *sl);
 /* Is the skiplist empty? */
 bool skiplist_empty(struct skiplist *sl);
 
+#if SKIPLIST_WIDTHS
+/* Count the keys that are >= MIN_KEY and <= MAX_KEY. O(log n),
+ * using the span widths maintained when SKIPLIST_WIDTHS is set. */
+size_t skiplist_count_range(struct skiplist *sl,
+    void *min_key, void *max_key);
+
+/* Get the IDX-th smallest pair (0-based; duplicates count
+ * separately) in O(log n). If key or value are non-NULL, the pair is
+ * returned in them. Returns false if IDX is out of bounds. */
+bool skiplist_at_index(struct skiplist *sl, size_t idx,
+    void **key, void **value);
+#endif
+
 /* Callback when iterating over the contents of the skiplist.
  * The return value determines whether to keep iterating.
  * UDATA is an extra void * for the callback's closure/enironment. */
@@ -154,16 +424,197 @@ void skiplist_iter(struct skiplist *sl,
 void skiplist_iter_from(struct skiplist *sl, void *key,
     skiplist_iter_cb *cb, void *udata);
 
+/* As skiplist_iter_from, but locating the starting key by comparing
+ * stored keys against PROBE with PCMP; see skiplist_probe_cmp_cb. */
+void skiplist_iter_from_ex(struct skiplist *sl, void *probe,
+    skiplist_probe_cmp_cb *pcmp, skiplist_iter_cb *cb, void *udata);
+
+#if SKIPLIST_BACK_POINTERS
+/* Iterate over the skiplist in descending key order, using the
+ * back-pointers maintained when SKIPLIST_BACK_POINTERS is set: one
+ * O(log n) descent to the last pair, then one pointer step per pair,
+ * so halting after the last N pairs costs O(log n + N). */
+void skiplist_iter_reverse(struct skiplist *sl,
+    skiplist_iter_cb *cb, void *udata);
+#endif
+
+/* Opaque cursor type, holding a position within a skiplist.
+ *
+ * A cursor avoids the per-pair callback dispatch of skiplist_iter,
+ * and multiple cursors over the same skiplist can be interleaved
+ * (e.g. for a merge join). Any operation that adds or removes pairs
+ * invalidates open cursors. */
+struct skiplist_cursor;
+
+/* Open a cursor positioned at the first pair in the skiplist.
+ * Returns NULL on allocation failure. */
+struct skiplist_cursor *skiplist_cursor_open(struct skiplist *sl);
+
+/* Position the cursor at the first pair with a key >= KEY.
+ * Returns whether the cursor is now positioned on a pair. */
+bool skiplist_cursor_seek(struct skiplist_cursor *c, void *key);
+
+/* Get the pair at the cursor's current position; NULL key/value
+ * arguments are ignored. Returns false if the cursor is off the
+ * end of the skiplist. */
+bool skiplist_cursor_get(struct skiplist_cursor *c,
+    void **key, void **value);
+
+/* Advance the cursor to the next pair.
+ * Returns whether the cursor is now positioned on a pair. */
+bool skiplist_cursor_next(struct skiplist_cursor *c);
+
+/* Step the cursor back to the previous pair, or to the last pair if
+ * the cursor is off the end. This costs a fresh O(log n) descent,
+ * or a single pointer step when SKIPLIST_BACK_POINTERS is set.
+ * Returns whether the cursor moved; if it is already on the first
+ * pair, it stays put and returns false. */
+bool skiplist_cursor_prev(struct skiplist_cursor *c);
+
+/* Close the cursor and free it. */
+void skiplist_cursor_close(struct skiplist_cursor *c);
+
 /* Clear the skiplist. Returns the number of pairs removed,
- * or 0 on error. */
+ * or 0 on error. A NULL CB falls back to the registered destructor,
+ * if any. */
 size_t skiplist_clear(struct skiplist *sl,
     skiplist_free_cb *cb, void *udata);
 
 /* Clear and free the skiplist. Returns the number of pairs removed,
- * or 0 on error. */
+ * or 0 on error. A NULL CB falls back to the registered destructor,
+ * if any. */
 size_t skiplist_free(struct skiplist *sl,
     skiplist_free_cb *cb, void *udata);
 
+/* Opaque handle to nodes detached with skiplist_detach, freed
+ * incrementally with skiplist_detach_drain. */
+struct skiplist_detached;
+
+/* Empty the skiplist in O(head height) time, moving every pair onto
+ * a detached handle whose nodes can then be freed incrementally --
+ * from a background thread, or in small time-sliced chunks -- where
+ * skiplist_clear would walk and free all of them inline. Returns
+ * NULL on allocation failure, leaving the skiplist unchanged.
+ *
+ * The skiplist is immediately empty and usable, but must outlive the
+ * handle: the handle's nodes are freed through the skiplist's
+ * allocator, so fully drain the handle before skiplist_free. Like
+ * skiplist_clear, this must not run concurrently with readers -- the
+ * detached nodes bypass the epoch limbo lists. */
+struct skiplist_detached *skiplist_detach(struct skiplist *sl);
+
+/* Free up to MAX_NODES pairs from the handle (0 means no limit),
+ * calling CB (optional, falling back to the skiplist's registered
+ * destructor) for each. Returns the number of pairs freed.
+ * When a call frees fewer than MAX_NODES pairs, the handle is
+ * exhausted and has been freed along with its last nodes; it must
+ * not be used again. */
+size_t skiplist_detach_drain(struct skiplist_detached *d,
+    size_t max_nodes, skiplist_free_cb *cb, void *udata);
+
+/* Concurrent reads with a single writer
+ * =====================================
+ *
+ * Any number of reader threads may call the read-only API
+ * (skiplist_get, skiplist_member, skiplist_first/last, skiplist_iter,
+ * cursors, ...) concurrently with ONE thread modifying the skiplist,
+ * provided each reader brackets its accesses with
+ * skiplist_epoch_enter/skiplist_epoch_leave. Readers never block.
+ *
+ * Once any reader has entered an epoch, nodes removed from the
+ * skiplist are no longer freed immediately: they are kept on a limbo
+ * list (with their forward pointers intact, so in-flight readers can
+ * traverse past them) until the writer calls skiplist_reclaim and no
+ * reader from an old enough epoch remains.
+ *
+ * Requires a compiler with GNU C atomics (gcc or clang); without
+ * them, the epoch calls still work but concurrent access is not safe.
+ * skiplist_free and skiplist_clear must not run concurrently with
+ * readers. */
+
+/* Enter a read epoch. Returns an epoch token which must be passed
+ * to the matching skiplist_epoch_leave. */
+unsigned skiplist_epoch_enter(struct skiplist *sl);
+
+/* Leave a read epoch entered with skiplist_epoch_enter. */
+void skiplist_epoch_leave(struct skiplist *sl, unsigned epoch);
+
+/* Free nodes whose removal is old enough that no current reader can
+ * still reach them, and advance the epoch. Must be called from the
+ * writer thread. Returns the number of nodes freed; 0 also means
+ * readers from an old epoch are still active, so call again later. */
+size_t skiplist_reclaim(struct skiplist *sl);
+
+/* Lock-free multi-writer variant
+ * ==============================
+ *
+ * A skiplist created with skiplist_new_concurrent supports any number
+ * of threads calling skiplist_concurrent_add/delete/get/member
+ * concurrently, with no locks: updates are CAS-based, with deletion
+ * marks on the victim's own forward pointers (Fraser/Harris style).
+ * Nodes share the regular node layout and allocator hooks.
+ *
+ * Rules:
+ *   - Only the skiplist_concurrent_* operations (plus skiplist_count
+ *     and skiplist_empty) may be used while other threads are active;
+ *     the rest of the API is only safe once writers are quiesced.
+ *   - Every thread must bracket its operations with
+ *     skiplist_epoch_enter/leave, since deleted nodes are reclaimed
+ *     through the epoch machinery; call skiplist_reclaim from one
+ *     thread at a time.
+ *   - Requires GNU C atomics (gcc or clang).
+ *   - The allocator callback must be thread-safe (the default
+ *     malloc/free is; skiplist_pool is not). */
+
+/* Create a skiplist for lock-free concurrent use. Unlike
+ * skiplist_new, the head node is allocated at full height up front,
+ * since concurrent operations cannot safely replace the head. */
+struct skiplist *skiplist_new_concurrent(skiplist_cmp_cb *cmp,
+    skiplist_alloc_cb *alloc, void *alloc_udata);
+
+/* Lock-free counterparts of skiplist_add, skiplist_delete,
+ * skiplist_get and skiplist_member. Unlike skiplist_add,
+ * skiplist_concurrent_add rejects duplicate keys (returns false):
+ * safe physical unlinking relies on keys being unique. */
+bool skiplist_concurrent_add(struct skiplist *sl, void *key, void *value);
+bool skiplist_concurrent_delete(struct skiplist *sl,
+    void *key, void **value);
+bool skiplist_concurrent_get(struct skiplist *sl, void *key, void **value);
+bool skiplist_concurrent_member(struct skiplist *sl, void *key);
+
+#if SKIPLIST_STATS
+/* Statistics snapshot, filled in by skiplist_stats. */
+struct skiplist_stats {
+    /* Live bytes currently allocated for the list: the list struct
+     * plus every node, including unlinked nodes still awaiting
+     * skiplist_reclaim. */
+    size_t bytes;
+
+    /* Number of live nodes of each height; NODES_AT_HEIGHT[h - 1]
+     * counts the nodes with height h. With the default generator
+     * each entry should be roughly half the one before it -- marked
+     * skew here usually means a bad SKIPLIST_GEN_HEIGHT override. */
+    size_t nodes_at_height[SKIPLIST_MAX_HEIGHT];
+
+    /* Cumulative searches and key comparisons (fingerprint ties
+     * included) across all search, update, and delete operations
+     * since the list was created. COMPARISONS / SEARCHES is the
+     * average search cost; expect about 2 * log2(count). */
+    uint64_t searches;
+    uint64_t comparisons;
+
+    /* How many times the head has grown to accommodate a taller
+     * node. This should level off quickly; steady growth is another
+     * height-distribution red flag. */
+    size_t head_grows;
+};
+
+/* Fill *OUT with a statistics snapshot for SL. The counters are
+ * cheap to maintain, but the height histogram costs one O(n) walk
+ * per call. Only available when compiled with SKIPLIST_STATS. */
+void skiplist_stats(struct skiplist *sl, struct skiplist_stats *out);
+#endif
+
 #if SKIPLIST_DEBUG
 #include <stdio.h>
 
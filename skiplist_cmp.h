@@ -0,0 +1,83 @@
+#ifndef SKIPLIST_CMP_H
+#define SKIPLIST_CMP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "skiplist_config.h"
+
+/* Comparators for fixed-size binary keys, in memcmp order: 16, 32,
+ * and 64 byte blobs, compared 16 or 32 bytes at a time with SSE2 or
+ * AVX2 when the compiler targets them (see SKIPLIST_CMP_VECTOR in
+ * skiplist_config.h), falling back to plain memcmp otherwise.
+ *
+ * Each can be passed to skiplist_new as the cmp callback directly.
+ * They are defined inline so that, combined with the inline-key and
+ * inline-comparison modes, the search loops can compare keys without
+ * a function-pointer call at all -- for 16-byte keys:
+ *
+ *     #define SKIPLIST_INLINE_KEY_SIZE 16
+ *     #define SKIPLIST_CMP_INLINE(a, b) skiplist_cmp_bytes16((a), (b))
+ *
+ * compiled the way skiplist_int_config.h builds the intptr_t-key
+ * specialization. */
+
+#if SKIPLIST_CMP_VECTOR && (defined(__SSE2__) || defined(__AVX2__))
+#include <immintrin.h>
+#endif
+
+/* Compare one 16-byte chunk: vector-compare for equality, then
+ * decide the order from the first differing byte. */
+#if SKIPLIST_CMP_VECTOR && defined(__SSE2__)
+static inline int sl_cmp_chunk16(const uint8_t *a, const uint8_t *b) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(const void *)a);
+    __m128i vb = _mm_loadu_si128((const __m128i *)(const void *)b);
+    unsigned diff = ~(unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(va, vb)) & 0xffffu;
+    if (diff == 0) { return 0; }
+    unsigned at = (unsigned)__builtin_ctz(diff);
+    return (int)a[at] - (int)b[at];
+}
+#else
+static inline int sl_cmp_chunk16(const uint8_t *a, const uint8_t *b) {
+    return memcmp(a, b, 16);
+}
+#endif
+
+/* Compare one 32-byte chunk. */
+#if SKIPLIST_CMP_VECTOR && defined(__AVX2__)
+static inline int sl_cmp_chunk32(const uint8_t *a, const uint8_t *b) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(const void *)a);
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(const void *)b);
+    uint32_t diff = ~(uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(va, vb));
+    if (diff == 0) { return 0; }
+    unsigned at = (unsigned)__builtin_ctz(diff);
+    return (int)a[at] - (int)b[at];
+}
+#else
+static inline int sl_cmp_chunk32(const uint8_t *a, const uint8_t *b) {
+    int res = sl_cmp_chunk16(a, b);
+    return res != 0 ? res : sl_cmp_chunk16(a + 16, b + 16);
+}
+#endif
+
+/* Compare two 16-byte keys, like memcmp(a, b, 16). */
+static inline int skiplist_cmp_bytes16(void *a, void *b) {
+    return sl_cmp_chunk16((const uint8_t *)a, (const uint8_t *)b);
+}
+
+/* Compare two 32-byte keys, like memcmp(a, b, 32). */
+static inline int skiplist_cmp_bytes32(void *a, void *b) {
+    return sl_cmp_chunk32((const uint8_t *)a, (const uint8_t *)b);
+}
+
+/* Compare two 64-byte keys, like memcmp(a, b, 64). */
+static inline int skiplist_cmp_bytes64(void *a, void *b) {
+    int res = sl_cmp_chunk32((const uint8_t *)a, (const uint8_t *)b);
+    return res != 0 ? res
+        : sl_cmp_chunk32((const uint8_t *)a + 32,
+                         (const uint8_t *)b + 32);
+}
+
+#endif
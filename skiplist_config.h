@@ -25,6 +25,92 @@
 #define SKIPLIST_DEBUG 0
 #endif
 
+/* If set to a nonzero size (in bytes), keys are fixed-size blobs of
+ * that many bytes, embedded directly in each node and copied from the
+ * key pointer on insert. This removes a pointer dereference (usually
+ * a cache miss) per comparison during searches.
+ *
+ * In this mode, the key pointers passed to the cmp callback (and
+ * returned from skiplist_first & friends) point at the node-internal
+ * copies, which are freed along with their node, and the caller's key
+ * storage can be reused as soon as the call returns. Keys must not be
+ * NULL. */
+#ifndef SKIPLIST_INLINE_KEY_SIZE
+#define SKIPLIST_INLINE_KEY_SIZE 0
+#endif
+
+/* Maintain a span width per forward pointer (the classic indexable
+ * skiplist), recording how many level-0 links each pointer covers.
+ * This enables skiplist_count_range and skiplist_at_index, which run
+ * in O(log n) instead of requiring an O(n) iteration, at the cost of
+ * one size_t per forward pointer and slightly more bookkeeping in the
+ * update operations. The widths are not maintained by the lock-free
+ * skiplist_concurrent_* operations. */
+#ifndef SKIPLIST_WIDTHS
+#define SKIPLIST_WIDTHS 0
+#endif
+
+/* Doubly link the bottom level: each node stores a pointer to its
+ * level-0 predecessor. This enables skiplist_iter_reverse and makes
+ * skiplist_cursor_prev a single pointer step instead of a fresh
+ * O(log n) descent, so "the last N pairs, descending" costs
+ * O(log n + N) instead of O(N log n), at the cost of one pointer
+ * per node. The back-pointers are not maintained by the lock-free
+ * skiplist_concurrent_* operations. */
+#ifndef SKIPLIST_BACK_POINTERS
+#define SKIPLIST_BACK_POINTERS 0
+#endif
+
+/* Store a 64-bit key fingerprint in each node and compare
+ * fingerprints before calling the cmp callback during searches (see
+ * skiplist_set_prefix_cb in skiplist.h). Worthwhile when comparisons
+ * are expensive -- e.g. long composite string keys where most
+ * comparisons resolve within the first few bytes -- at the cost of
+ * 8 bytes per node. */
+#ifndef SKIPLIST_FINGERPRINT
+#define SKIPLIST_FINGERPRINT 0
+#endif
+
+/* Let the fixed-size byte comparators in skiplist_cmp.h use SSE2 or
+ * AVX2 compare instructions when the compiler targets them
+ * (__SSE2__/__AVX2__). Build with 0 to force the portable
+ * memcmp-based path. */
+#ifndef SKIPLIST_CMP_VECTOR
+#define SKIPLIST_CMP_VECTOR 1
+#endif
+
+/* Maintain per-list statistics counters and include skiplist_stats
+ * (see skiplist.h): live bytes allocated, node counts per height,
+ * cumulative searches and key comparisons, and head-growth events.
+ * Useful for sizing memory on large lists and for spotting
+ * height-distribution skew from a bad SKIPLIST_GEN_HEIGHT override.
+ * Adds a few counter updates to the search and update paths. */
+#ifndef SKIPLIST_STATS
+#define SKIPLIST_STATS 0
+#endif
+
+/* Pairs per block in the unrolled variant (skiplist_unrolled.h).
+ * Larger blocks mean fewer pointer dereferences and less memory
+ * overhead per pair, at the cost of more memmove work per update;
+ * something in the 8..16 range is usually a good trade. */
+#ifndef SKIPLIST_UNROLL_B
+#define SKIPLIST_UNROLL_B 8
+#endif
+
+/* Define to replace the skiplist_cmp_cb function-pointer call with an
+ * inlined comparison expression, so the compiler can inline it into
+ * the search loops. (a) and (b) are the two keys (void *), and the
+ * expression must evaluate to <0, 0, or >0 like a cmp callback.
+ * For example, for intptr_t keys (see skiplist_int_config.h):
+ *
+ *     #define SKIPLIST_CMP_INLINE(a, b)                   \
+ *         (((intptr_t)(a) < (intptr_t)(b)) ? -1 :         \
+ *          ((intptr_t)(a) > (intptr_t)(b)) ? 1 : 0)
+ *
+ * When defined, the cmp callback is unused and skiplist_new
+ * accepts a NULL cmp argument. */
+/* #define SKIPLIST_CMP_INLINE(a, b) */
+
 /* Define a custom random-height-calculation function.
  * 
  * To keep expected skiplist behavior, the probability of a
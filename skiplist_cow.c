@@ -0,0 +1,404 @@
+/*
+ * Copy-on-write skiplist container with point-in-time snapshots.
+ *
+ * The container is a stack of plain skiplists: one mutable top layer
+ * that receives all writes, over zero or more frozen layers. A
+ * snapshot freezes the top layer (pushing a fresh empty one) and
+ * takes a reference on it; the frozen layers are shared between the
+ * live view and every snapshot, so a snapshot costs O(1) no matter
+ * how large the list is. Newer layers shadow older ones, and a
+ * deletion whose key still exists in an older layer is recorded as a
+ * tombstone so the older pair stays hidden from the live view.
+ *
+ * True path copying -- copying just the O(log n) nodes on a write
+ * path, as in persistent balanced trees -- is unsound in a skiplist:
+ * a node on the search path can have incoming pointers from nodes
+ * the search never visited, which would keep referencing the old
+ * version. Layering gets the same O(log n)-per-write sharing without
+ * that hazard, at the cost of one extra search per stacked layer on
+ * reads; released layers are squashed back into their older neighbor
+ * to keep the stack shallow.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "skiplist_cow.h"
+#include "skiplist_config.h"
+#include "skiplist_macros_internal.h"
+
+/* One layer: a plain skiplist plus how many snapshots' views start
+ * here. The top (mutable) layer always has zero refs. */
+struct cow_layer {
+    struct skiplist *sl;
+    size_t refs;
+    struct cow_layer *below;
+};
+
+struct skiplist_cow {
+    skiplist_cmp_cb *cmp;
+    skiplist_alloc_cb *alloc;
+    void *alloc_udata;
+    struct cow_layer *top;
+    skiplist_free_cb *drop_cb;
+    void *drop_udata;
+    size_t snaps;               /* live snapshots, across all layers */
+};
+
+struct skiplist_cow_snap {
+    struct skiplist_cow *cow;
+    struct cow_layer *layer;    /* newest frozen layer in the view */
+};
+
+/* Tombstone marker: stored as the value of a deleted key whose older
+ * version must stay shadowed. Never visible to callers. */
+static char tombstone_tag;
+#define TOMBSTONE ((void *)&tombstone_tag)
+
+static void *def_alloc(void *p,
+        size_t osize, size_t nsize, void *udata) {
+    (void)udata;
+    (void)osize;
+    if (p) {
+        assert(nsize == 0);
+        free(p);
+        return NULL;
+    } else {
+        assert(osize == 0);
+        return malloc(nsize);
+    }
+}
+
+/* Hand a pair that has dropped out of every view to the drop
+ * callback. Tombstones and NULL values are not caller pairs. */
+static void drop_pair(struct skiplist_cow *cow, void *key, void *value) {
+    if (value == NULL || value == TOMBSTONE) { return; }
+    if (cow->drop_cb) { cow->drop_cb(key, value, cow->drop_udata); }
+}
+
+static struct cow_layer *layer_new(struct skiplist_cow *cow) {
+    struct cow_layer *l = cow->alloc(NULL, 0,
+        sizeof(*l), cow->alloc_udata);
+    if (l == NULL) { return NULL; }
+    l->sl = skiplist_new(cow->cmp, cow->alloc, cow->alloc_udata);
+    if (l->sl == NULL) {
+        cow->alloc(l, sizeof(*l), 0, cow->alloc_udata);
+        return NULL;
+    }
+    l->refs = 0;
+    l->below = NULL;
+    return l;
+}
+
+static void layer_free(struct skiplist_cow *cow, struct cow_layer *l) {
+    skiplist_free(l->sl, NULL, NULL);
+    cow->alloc(l, sizeof(*l), 0, cow->alloc_udata);
+}
+
+struct skiplist_cow *skiplist_cow_new(skiplist_cmp_cb *cmp,
+        skiplist_alloc_cb *alloc, void *alloc_udata) {
+    if (cmp == NULL) { return NULL; }
+    if (alloc == NULL) { alloc = def_alloc; }
+
+    struct skiplist_cow *cow = alloc(NULL, 0, sizeof(*cow), alloc_udata);
+    if (cow) {
+        cow->cmp = cmp;
+        cow->alloc = alloc;
+        cow->alloc_udata = alloc_udata;
+        cow->drop_cb = NULL;
+        cow->drop_udata = NULL;
+        cow->snaps = 0;
+        cow->top = layer_new(cow);
+        if (cow->top == NULL) {
+            alloc(cow, sizeof(*cow), 0, alloc_udata);
+            return NULL;
+        }
+    }
+    return cow;
+}
+
+void skiplist_cow_set_drop_cb(struct skiplist_cow *cow,
+        skiplist_free_cb *cb, void *udata) {
+    assert(cow);
+    cow->drop_cb = cb;
+    cow->drop_udata = udata;
+}
+
+/* Look KEY up in the view starting at layer L: the newest layer
+ * that contains it wins, and a tombstone means deleted. */
+static bool layers_get(struct cow_layer *l, void *key, void **value) {
+    for (; l != NULL; l = l->below) {
+        void *v = NULL;
+        if (skiplist_get(l->sl, key, &v)) {
+            if (v == TOMBSTONE) { return false; }
+            if (value) { *value = v; }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool skiplist_cow_get(struct skiplist_cow *cow, void *key, void **value) {
+    assert(cow);
+    return layers_get(cow->top, key, value);
+}
+
+bool skiplist_cow_member(struct skiplist_cow *cow, void *key) {
+    return skiplist_cow_get(cow, key, NULL);
+}
+
+bool skiplist_cow_add(struct skiplist_cow *cow, void *key, void *value) {
+    assert(cow);
+    void *old = NULL;
+    if (!skiplist_set(cow->top->sl, key, value, &old)) { return false; }
+    /* A value replaced within the mutable layer was never visible to
+     * any snapshot, so it is dropped right away. */
+    drop_pair(cow, key, old);
+    return true;
+}
+
+bool skiplist_cow_delete(struct skiplist_cow *cow, void *key) {
+    assert(cow);
+    struct cow_layer *top = cow->top;
+    void *v = NULL;
+
+    if (skiplist_get(top->sl, key, &v)) {
+        if (v == TOMBSTONE) { return false; }   /* already deleted */
+        void *old = NULL;
+        if (layers_get(top->below, key, NULL)) {
+            /* An older version is still visible underneath: shadow
+             * it, reusing the existing node for the tombstone. */
+            if (!skiplist_set(top->sl, key, TOMBSTONE, &old)) {
+                return false;
+            }
+        } else {
+            skiplist_delete(top->sl, key, &old);
+        }
+        drop_pair(cow, key, old);
+        return true;
+    }
+
+    if (!layers_get(top->below, key, NULL)) { return false; }
+    /* The pair lives in a frozen layer: it stays put for the
+     * snapshots, hidden from the live view by a tombstone, and
+     * reaches the drop callback when its layer is squashed. */
+    return skiplist_set(top->sl, key, TOMBSTONE, NULL);
+}
+
+/* Apply every entry of FROM onto the older layer INTO, newest-wins.
+ * When INTO is the bottom layer there is nothing left to shadow, so
+ * tombstones delete outright instead of being copied down. Returns
+ * false if an allocation failed partway; the entries already applied
+ * are still shadowed by FROM, so the composed view is unchanged and
+ * the caller just keeps FROM. */
+struct layer_apply_env {
+    struct skiplist_cow *cow;
+    struct skiplist *into;
+    bool bottom;
+    bool ok;
+};
+
+static enum skiplist_iter_res layer_apply_cb(void *key, void *value,
+        void *udata) {
+    struct layer_apply_env *env = (struct layer_apply_env *)udata;
+    void *old = NULL;
+    if (value == TOMBSTONE && env->bottom) {
+        if (skiplist_delete(env->into, key, &old)) {
+            drop_pair(env->cow, key, old);
+        }
+        return SKIPLIST_ITER_CONTINUE;
+    }
+    if (!skiplist_set(env->into, key, value, &old)) {
+        env->ok = false;
+        return SKIPLIST_ITER_HALT;
+    }
+    drop_pair(env->cow, key, old);
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+static bool layer_apply(struct skiplist_cow *cow,
+        struct skiplist *from, struct cow_layer *into) {
+    struct layer_apply_env env = {
+        .cow = cow,
+        .into = into->sl,
+        .bottom = into->below == NULL,
+        .ok = true,
+    };
+    skiplist_iter(from, layer_apply_cb, &env);
+    return env.ok;
+}
+
+/* Squash layers no snapshot needs any more. Folding a refs-zero
+ * frozen layer into its refs-zero older neighbor preserves the
+ * composed contents of every view that still includes it, so the
+ * stack stays at most two layers deeper than the live snapshot
+ * count. With no snapshots left at all, the mutable top is folded
+ * down too, back to a single layer. */
+static void cow_squash(struct skiplist_cow *cow) {
+    struct cow_layer **pp = &cow->top->below;
+    while (*pp != NULL && (*pp)->below != NULL) {
+        struct cow_layer *f = *pp, *b = f->below;
+        if (f->refs == 0 && b->refs == 0) {
+            if (!layer_apply(cow, f->sl, b)) { return; }
+            *pp = b;
+            layer_free(cow, f);
+        } else {
+            pp = &f->below;
+        }
+    }
+
+    struct cow_layer *top = cow->top, *b = top->below;
+    if (cow->snaps == 0 && b != NULL
+        && b->refs == 0 && b->below == NULL) {
+        if (!layer_apply(cow, top->sl, b)) { return; }
+        cow->top = b;
+        layer_free(cow, top);
+    }
+}
+
+struct skiplist_cow_snap *skiplist_cow_snapshot(struct skiplist_cow *cow) {
+    assert(cow);
+    struct skiplist_cow_snap *snap = cow->alloc(NULL, 0,
+        sizeof(*snap), cow->alloc_udata);
+    if (snap == NULL) { return NULL; }
+
+    struct cow_layer *layer = NULL;
+    if (skiplist_empty(cow->top->sl) && cow->top->below != NULL) {
+        /* Nothing written since the last freeze: share it. */
+        layer = cow->top->below;
+    } else {
+        struct cow_layer *fresh = layer_new(cow);
+        if (fresh == NULL) {
+            cow->alloc(snap, sizeof(*snap), 0, cow->alloc_udata);
+            return NULL;
+        }
+        fresh->below = cow->top;
+        cow->top = fresh;       /* old top is frozen from here on */
+        layer = fresh->below;
+    }
+    layer->refs++;
+    cow->snaps++;
+    snap->cow = cow;
+    snap->layer = layer;
+    return snap;
+}
+
+bool skiplist_cow_snap_get(struct skiplist_cow_snap *snap,
+        void *key, void **value) {
+    assert(snap);
+    return layers_get(snap->layer, key, value);
+}
+
+void skiplist_cow_snap_iter(struct skiplist_cow_snap *snap,
+        skiplist_iter_cb *cb, void *udata) {
+    assert(snap);
+    assert(cb);
+    struct skiplist_cow *cow = snap->cow;
+
+    int nl = 0;
+    for (struct cow_layer *l = snap->layer; l; l = l->below) { nl++; }
+    struct skiplist_cursor *cs[nl];
+    int opened = 0;
+    for (struct cow_layer *l = snap->layer; l; l = l->below) {
+        cs[opened] = skiplist_cursor_open(l->sl);
+        if (cs[opened] == NULL) { goto cleanup; }
+        opened++;
+    }
+
+    /* Merge the layer cursors: on each round the smallest current
+     * key wins, ties going to the newest layer (lowest index), and
+     * every cursor parked on that key steps past its now-shadowed
+     * entry. */
+    for (;;) {
+        int best = -1;
+        void *bk = NULL, *bv = NULL;
+        for (int l = 0; l < nl; l++) {
+            void *k = NULL, *v = NULL;
+            if (!skiplist_cursor_get(cs[l], &k, &v)) { continue; }
+            if (best < 0 || cow->cmp(k, bk) < 0) {
+                best = l;
+                bk = k;
+                bv = v;
+            }
+        }
+        if (best < 0) { break; }
+        for (int l = 0; l < nl; l++) {
+            void *k = NULL;
+            if (skiplist_cursor_get(cs[l], &k, NULL)
+                && cow->cmp(k, bk) == 0) {
+                skiplist_cursor_next(cs[l]);
+            }
+        }
+        if (bv == TOMBSTONE) { continue; }
+        if (cb(bk, bv, udata) != SKIPLIST_ITER_CONTINUE) { break; }
+    }
+
+cleanup:
+    for (int l = 0; l < opened; l++) { skiplist_cursor_close(cs[l]); }
+}
+
+void skiplist_cow_snap_release(struct skiplist_cow_snap *snap) {
+    assert(snap);
+    struct skiplist_cow *cow = snap->cow;
+    assert(snap->layer->refs > 0);
+    snap->layer->refs--;
+    assert(cow->snaps > 0);
+    cow->snaps--;
+    cow->alloc(snap, sizeof(*snap), 0, cow->alloc_udata);
+    cow_squash(cow);
+}
+
+struct cow_free_env {
+    struct skiplist_cow *cow;
+    struct cow_layer *layer;    /* the layer being iterated */
+    skiplist_free_cb *cb;
+    void *udata;
+    size_t ct;
+};
+
+static enum skiplist_iter_res cow_free_cb(void *key, void *value,
+        void *udata) {
+    struct cow_free_env *env = (struct cow_free_env *)udata;
+    if (value == TOMBSTONE) { return SKIPLIST_ITER_CONTINUE; }
+
+    /* Visible, unless some newer layer shadows the key (a squash
+     * that failed on allocation can leave more than one layer even
+     * with no snapshots outstanding). */
+    for (struct cow_layer *l = env->cow->top;
+         l != env->layer; l = l->below) {
+        if (skiplist_member(l->sl, key)) {
+            drop_pair(env->cow, key, value);
+            return SKIPLIST_ITER_CONTINUE;
+        }
+    }
+    env->ct++;
+    if (env->cb) { env->cb(key, value, env->udata); }
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+size_t skiplist_cow_free(struct skiplist_cow *cow,
+        skiplist_free_cb *cb, void *udata) {
+    assert(cow);
+    assert(cow->snaps == 0);
+    struct cow_free_env env = {
+        .cow = cow,
+        .cb = cb,
+        .udata = udata,
+        .ct = 0,
+    };
+    for (struct cow_layer *l = cow->top; l; l = l->below) {
+        env.layer = l;
+        skiplist_iter(l->sl, cow_free_cb, &env);
+    }
+    for (struct cow_layer *l = cow->top; l != NULL; ) {
+        struct cow_layer *below = l->below;
+        layer_free(cow, l);
+        l = below;
+    }
+    skiplist_alloc_cb *alloc = cow->alloc;
+    void *alloc_udata = cow->alloc_udata;
+    size_t ct = env.ct;
+    alloc(cow, sizeof(*cow), 0, alloc_udata);
+    return ct;
+}
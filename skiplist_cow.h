@@ -0,0 +1,89 @@
+#ifndef SKIPLIST_COW_H
+#define SKIPLIST_COW_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "skiplist.h"
+
+/* A copy-on-write skiplist container supporting cheap point-in-time
+ * snapshots: skiplist_cow_snapshot freezes the current contents in
+ * O(1) and returns a read-only handle, while writes keep going to
+ * the live view. Internally the container is a short stack of plain
+ * skiplists: one mutable top layer plus frozen layers shared (not
+ * copied) between the live view and any snapshots, with newer layers
+ * shadowing older ones and deletions recorded as tombstones. Each
+ * write costs one extra O(log n) search; reads walk the layer stack,
+ * which stays at most two layers deeper than the number of live
+ * snapshots because released layers are squashed back down.
+ *
+ * Keys are unique here (adding an existing key replaces its value),
+ * and the container does not own keys or values: pairs that fall out
+ * of every view -- replaced, deleted, or shadowed -- are handed to
+ * the optional drop callback exactly once, when no snapshot can
+ * still read them. The callback types are shared with skiplist.h. */
+
+struct skiplist_cow;
+struct skiplist_cow_snap;
+
+/* Create a new copy-on-write skiplist, returns NULL on error.
+ * The arguments are as in skiplist_new; cmp is required. */
+struct skiplist_cow *skiplist_cow_new(skiplist_cmp_cb *cmp,
+    skiplist_alloc_cb *alloc, void *alloc_udata);
+
+/* Set the callback invoked (with UDATA) for each key/value pair
+ * that has dropped out of the live view and every snapshot: replaced
+ * values, deleted pairs, and shadowed pairs discarded when layers
+ * are squashed. NULL (the default) discards them silently. Values
+ * that compare equal to NULL never reach the callback. */
+void skiplist_cow_set_drop_cb(struct skiplist_cow *cow,
+    skiplist_free_cb *cb, void *udata);
+
+/* Associate KEY with VALUE in the live view, replacing the value if
+ * the key is already present. Returns false on allocation failure. */
+bool skiplist_cow_add(struct skiplist_cow *cow, void *key, void *value);
+
+/* Delete the association for KEY from the live view. Snapshots are
+ * unaffected; the pair reaches the drop callback once the last
+ * snapshot that can see it is released. Returns whether the key was
+ * present, or false on allocation failure (when the deletion must
+ * be recorded as a tombstone). */
+bool skiplist_cow_delete(struct skiplist_cow *cow, void *key);
+
+/* Get the value associated with KEY in the live view. If the key is
+ * found and VALUE is non-NULL, it will be written into *VALUE.
+ * Returns whether the key was found. */
+bool skiplist_cow_get(struct skiplist_cow *cow, void *key, void **value);
+
+/* Does the live view contain KEY? */
+bool skiplist_cow_member(struct skiplist_cow *cow, void *key);
+
+/* Take a point-in-time snapshot of the live view, sharing its nodes
+ * rather than copying them: O(1), no matter the size. Subsequent
+ * writes leave the snapshot's view untouched. Returns NULL on
+ * allocation failure. */
+struct skiplist_cow_snap *skiplist_cow_snapshot(struct skiplist_cow *cow);
+
+/* Get the value associated with KEY as of the snapshot. */
+bool skiplist_cow_snap_get(struct skiplist_cow_snap *snap,
+    void *key, void **value);
+
+/* Iterate over the snapshot's pairs in ascending key order. The
+ * iteration callback type is shared with skiplist_iter. */
+void skiplist_cow_snap_iter(struct skiplist_cow_snap *snap,
+    skiplist_iter_cb *cb, void *udata);
+
+/* Release the snapshot. Frozen layers no snapshot needs any more
+ * are squashed back into their neighbors, handing shadowed and
+ * deleted pairs to the drop callback. */
+void skiplist_cow_snap_release(struct skiplist_cow_snap *snap);
+
+/* Free the container. Every snapshot must have been released. If CB
+ * is non-NULL it is called on each pair still in the live view;
+ * pairs only visible in already-released layers go to the drop
+ * callback as usual. Returns the number of live pairs freed. */
+size_t skiplist_cow_free(struct skiplist_cow *cow,
+    skiplist_free_cb *cb, void *udata);
+
+#endif
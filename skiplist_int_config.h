@@ -0,0 +1,13 @@
+#ifndef SKIPLIST_INT_CONFIG_H
+#define SKIPLIST_INT_CONFIG_H
+
+/* Configuration for libskiplist_int.a: keys are intptr_t values
+ * cast to void *, compared inline rather than through the cmp
+ * callback. Build with
+ *   -DSKIPLIST_LOCAL_INCLUDE=\"skiplist_int_config.h\" . */
+
+#define SKIPLIST_CMP_INLINE(a, b)                       \
+        (((intptr_t)(a) < (intptr_t)(b)) ? -1 :         \
+         ((intptr_t)(a) > (intptr_t)(b)) ? 1 : 0)
+
+#endif
@@ -19,4 +19,39 @@
 #define DO(count, block)                                \
         { for(int i=0; i<count; i++) { block; } }
 
+/* Atomic load/store wrappers, used so that readers can traverse the
+ * skiplist while a single writer updates it (see skiplist_epoch_enter
+ * in skiplist.h). With GNU C atomics these compile to plain loads and
+ * stores on x86; on compilers without them they fall back to ordinary
+ * accesses and concurrent readers are NOT supported. */
+#if defined(__GNUC__) || defined(__clang__)
+#define SL_LOAD_ACQ(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SL_STORE_REL(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SL_LOAD_SC(p)           __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define SL_STORE_SC(p, v)       __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define SL_FADD_SC(p, v)        __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define SL_FSUB_SC(p, v)        __atomic_fetch_sub((p), (v), __ATOMIC_SEQ_CST)
+/* Compare-and-swap *P from OLD to NEW; returns whether it swapped.
+ * OLD is a value, not a pointer to the expected value. */
+#define SL_CAS(p, old, new)                                             \
+        __extension__ ({                                                \
+                __typeof__(old) sl_cas_exp_ = (old);                    \
+                __atomic_compare_exchange_n((p), &sl_cas_exp_, (new),   \
+                    false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);         \
+        })
+/* Prefetch hint, used to overlap the memory latency of independent
+ * searches (see skiplist_get_many). */
+#define SL_PREFETCH(p)          __builtin_prefetch((p))
+#else
+#define SL_LOAD_ACQ(p)          (*(p))
+#define SL_STORE_REL(p, v)      (*(p) = (v))
+#define SL_LOAD_SC(p)           (*(p))
+#define SL_STORE_SC(p, v)       (*(p) = (v))
+#define SL_FADD_SC(p, v)        ((*(p) += (v)) - (v))
+#define SL_FSUB_SC(p, v)        ((*(p) -= (v)) + (v))
+#define SL_CAS(p, old, new)                                             \
+        ((*(p) == (old)) ? (*(p) = (new), 1) : 0)
+#define SL_PREFETCH(p)          ((void)(p))
+#endif
+
 #endif
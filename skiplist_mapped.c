@@ -0,0 +1,330 @@
+/*
+ * Read-only compact format, served straight from an mmap'd file.
+ *
+ * On-file layout (native byte order, like skiplist_serialize):
+ *
+ *     header: magic "slcf", format version, pair count,
+ *             offset of the index
+ *     records: one per pair in key order -- key length and value
+ *             length as uint32, then the key and value bytes,
+ *             padded so every record starts 8-aligned
+ *     index:  one uint64 file offset per record, in key order
+ *
+ * Readers binary-search the index, comparing the probe key against
+ * the record keys in place, so opening a file costs one mmap and no
+ * per-pair work: the first search faults in only the O(log n) pages
+ * it touches, and the pages are shared between every process with
+ * the same file open.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "skiplist_mapped.h"
+#include "skiplist_config.h"
+#include "skiplist_macros_internal.h"
+
+#define SLCF_MAGIC "slcf"
+#define SLCF_VERSION 1
+
+struct slcf_header {
+    char magic[4];
+    uint8_t version;
+    uint8_t pad[3];
+    uint64_t count;
+    uint64_t index_off;
+};
+
+struct skiplist_m {
+    void *base;                 /* the whole mapping */
+    size_t size;
+    size_t count;
+    const uint64_t *index;      /* record offsets, in key order */
+    skiplist_m_cmp_cb *cmp;
+};
+
+/* Round a record up so the next one starts 8-aligned, keeping the
+ * index and the length fields naturally aligned. */
+#define SLCF_ALIGN(len) (((len) + 7u) & ~(uint64_t)7u)
+
+/* Default key order: bytewise, shorter key first on a shared
+ * prefix. Matches memcmp- and (ASCII) strcmp-ordered keys. */
+static int m_cmp_bytes(const void *a, size_t a_len,
+        const void *b, size_t b_len) {
+    size_t min = a_len < b_len ? a_len : b_len;
+    int res = memcmp(a, b, min);
+    if (res != 0) { return res; }
+    return a_len < b_len ? -1 : a_len > b_len ? 1 : 0;
+}
+
+static void record_get(const struct skiplist_m *m, size_t index,
+        const void **key, size_t *key_len,
+        const void **value, size_t *value_len) {
+    assert(index < m->count);
+    const uint8_t *rec = (const uint8_t *)m->base + m->index[index];
+    uint32_t klen, vlen;
+    memcpy(&klen, rec, sizeof(klen));
+    memcpy(&vlen, rec + sizeof(klen), sizeof(vlen));
+    if (key) { *key = rec + 2 * sizeof(uint32_t); }
+    if (key_len) { *key_len = klen; }
+    if (value) { *value = rec + 2 * sizeof(uint32_t) + klen; }
+    if (value_len) { *value_len = vlen; }
+}
+
+/* ---- writing ---- */
+
+struct compact_env {
+    FILE *f;
+    uint64_t *offsets;
+    size_t ct;
+    uint64_t pos;
+    skiplist_m_encode_cb *encode;
+    void *udata;
+    bool ok;
+};
+
+static enum skiplist_iter_res compact_pair_cb(void *key, void *value,
+        void *udata) {
+    struct compact_env *env = (struct compact_env *)udata;
+    const void *kbuf = NULL, *vbuf = NULL;
+    size_t klen = 0, vlen = 0;
+    if (!env->encode(key, value, &kbuf, &klen, &vbuf, &vlen,
+            env->udata)) {
+        goto fail;
+    }
+    if (klen > UINT32_MAX || vlen > UINT32_MAX) { goto fail; }
+    uint32_t lens[2] = { (uint32_t)klen, (uint32_t)vlen };
+    if (fwrite(lens, sizeof(lens), 1, env->f) != 1) { goto fail; }
+    if (klen > 0 && fwrite(kbuf, klen, 1, env->f) != 1) { goto fail; }
+    if (vlen > 0 && fwrite(vbuf, vlen, 1, env->f) != 1) { goto fail; }
+
+    uint64_t len = sizeof(lens) + klen + vlen;
+    uint64_t padded = SLCF_ALIGN(len);
+    static const uint8_t zeros[8] = { 0 };
+    if (padded > len
+        && fwrite(zeros, padded - len, 1, env->f) != 1) {
+        goto fail;
+    }
+    env->offsets[env->ct] = env->pos;
+    env->ct++;
+    env->pos += padded;
+    return SKIPLIST_ITER_CONTINUE;
+
+fail:
+    env->ok = false;
+    return SKIPLIST_ITER_HALT;
+}
+
+bool skiplist_compact_to_file(struct skiplist *sl, const char *path,
+        skiplist_m_encode_cb *encode, void *udata) {
+    assert(sl);
+    assert(path);
+    assert(encode);
+    size_t count = skiplist_count(sl);
+    uint64_t *offsets = NULL;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) { return false; }
+    if (count > 0) {
+        offsets = malloc(count * sizeof(uint64_t));
+        if (offsets == NULL) { goto fail; }
+    }
+
+    struct slcf_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SLCF_MAGIC, sizeof(hdr.magic));
+    hdr.version = SLCF_VERSION;
+    hdr.count = count;
+    /* index_off is patched in below, once it is known. */
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1) { goto fail; }
+
+    struct compact_env env = {
+        .f = f,
+        .offsets = offsets,
+        .pos = sizeof(hdr),
+        .encode = encode,
+        .udata = udata,
+        .ok = true,
+    };
+    skiplist_iter(sl, compact_pair_cb, &env);
+    if (!env.ok) { goto fail; }
+    assert(env.ct == count);
+
+    hdr.index_off = env.pos;
+    if (count > 0
+        && fwrite(offsets, count * sizeof(uint64_t), 1, f) != 1) {
+        goto fail;
+    }
+    if (fseek(f, 0, SEEK_SET) != 0) { goto fail; }
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1) { goto fail; }
+    if (fclose(f) != 0) {
+        f = NULL;
+        goto fail;
+    }
+    free(offsets);
+    return true;
+
+fail:
+    if (f) { fclose(f); }
+    free(offsets);
+    remove(path);
+    return false;
+}
+
+/* ---- reading ---- */
+
+struct skiplist_m *skiplist_m_open(const char *path,
+        skiplist_m_cmp_cb *cmp) {
+    assert(path);
+    if (cmp == NULL) { cmp = m_cmp_bytes; }
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) { return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) == -1
+        || (size_t)st.st_size < sizeof(struct slcf_header)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);                  /* the mapping keeps the file alive */
+    if (base == MAP_FAILED) { return NULL; }
+
+    const struct slcf_header *hdr = (const struct slcf_header *)base;
+    if (memcmp(hdr->magic, SLCF_MAGIC, sizeof(hdr->magic)) != 0
+        || hdr->version != SLCF_VERSION
+        || hdr->index_off > size
+        || hdr->count > (size - hdr->index_off) / sizeof(uint64_t)) {
+        munmap(base, size);
+        return NULL;
+    }
+
+    /* The header is sane; now walk the index once and check that
+     * every record's length fields and payload lie inside the
+     * record area, so a corrupt or truncated file is rejected here
+     * instead of faulting in record_get later. */
+    const uint64_t *index = (const uint64_t *)
+        (const void *)((const uint8_t *)base + hdr->index_off);
+    for (uint64_t i = 0; i < hdr->count; i++) {
+        uint64_t off = index[i];
+        if (off < sizeof(*hdr)
+            || off > hdr->index_off
+            || hdr->index_off - off < 2 * sizeof(uint32_t)) {
+            munmap(base, size);
+            return NULL;
+        }
+        uint32_t klen, vlen;
+        memcpy(&klen, (const uint8_t *)base + off, sizeof(klen));
+        memcpy(&vlen, (const uint8_t *)base + off + sizeof(klen),
+            sizeof(vlen));
+        if (hdr->index_off - off - 2 * sizeof(uint32_t)
+            < (uint64_t)klen + vlen) {
+            munmap(base, size);
+            return NULL;
+        }
+    }
+
+    struct skiplist_m *m = malloc(sizeof(*m));
+    if (m == NULL) {
+        munmap(base, size);
+        return NULL;
+    }
+    m->base = base;
+    m->size = size;
+    m->count = hdr->count;
+    m->index = index;
+    m->cmp = cmp;
+    return m;
+}
+
+size_t skiplist_m_count(const struct skiplist_m *m) {
+    assert(m);
+    return m->count;
+}
+
+/* Index of the first record with key >= KEY (possibly m->count):
+ * the binary-search analogue of get_first_geq_node. */
+static size_t first_geq_index(const struct skiplist_m *m,
+        const void *key, size_t key_len) {
+    size_t lo = 0, hi = m->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const void *rk = NULL;
+        size_t rklen = 0;
+        record_get(m, mid, &rk, &rklen, NULL, NULL);
+        if (m->cmp(rk, rklen, key, key_len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool skiplist_m_get(const struct skiplist_m *m,
+        const void *key, size_t key_len,
+        const void **value, size_t *value_len) {
+    assert(m);
+    size_t at = first_geq_index(m, key, key_len);
+    if (at == m->count) { return false; }
+    const void *rk = NULL, *rv = NULL;
+    size_t rklen = 0, rvlen = 0;
+    record_get(m, at, &rk, &rklen, &rv, &rvlen);
+    if (m->cmp(rk, rklen, key, key_len) != 0) { return false; }
+    if (value) { *value = rv; }
+    if (value_len) { *value_len = rvlen; }
+    return true;
+}
+
+bool skiplist_m_member(const struct skiplist_m *m,
+        const void *key, size_t key_len) {
+    return skiplist_m_get(m, key, key_len, NULL, NULL);
+}
+
+bool skiplist_m_at_index(const struct skiplist_m *m, size_t index,
+        const void **key, size_t *key_len,
+        const void **value, size_t *value_len) {
+    assert(m);
+    if (index >= m->count) { return false; }
+    record_get(m, index, key, key_len, value, value_len);
+    return true;
+}
+
+static void iter_at(const struct skiplist_m *m, size_t at,
+        skiplist_m_iter_cb *cb, void *udata) {
+    for (; at < m->count; at++) {
+        const void *k = NULL, *v = NULL;
+        size_t klen = 0, vlen = 0;
+        record_get(m, at, &k, &klen, &v, &vlen);
+        if (cb(k, klen, v, vlen, udata) != SKIPLIST_ITER_CONTINUE) {
+            return;
+        }
+    }
+}
+
+void skiplist_m_iter(const struct skiplist_m *m,
+        skiplist_m_iter_cb *cb, void *udata) {
+    assert(m);
+    assert(cb);
+    iter_at(m, 0, cb, udata);
+}
+
+void skiplist_m_iter_from(const struct skiplist_m *m,
+        const void *key, size_t key_len,
+        skiplist_m_iter_cb *cb, void *udata) {
+    assert(m);
+    assert(cb);
+    iter_at(m, first_geq_index(m, key, key_len), cb, udata);
+}
+
+void skiplist_m_close(struct skiplist_m *m) {
+    assert(m);
+    munmap(m->base, m->size);
+    free(m);
+}
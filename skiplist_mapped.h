@@ -0,0 +1,92 @@
+#ifndef SKIPLIST_MAPPED_H
+#define SKIPLIST_MAPPED_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "skiplist.h"
+
+/* A read-only compact format for sharing a finished skiplist across
+ * processes: skiplist_compact_to_file writes the pairs into a
+ * position-independent flat file (offsets instead of pointers, keys
+ * and values as inline byte ranges), and skiplist_m_open mmaps it
+ * and serves reads directly against the mapping -- no
+ * deserialization, no per-process heap copy, one physical copy in
+ * the page cache no matter how many workers open it.
+ *
+ * Since the mapping holds byte ranges rather than live pointers, the
+ * readers mirror the main API in _m form: skiplist_m_get,
+ * skiplist_m_iter/_iter_from, and positional access with
+ * skiplist_m_at_index (which also serves as a cursor: a position in
+ * a frozen file is just an index). Lookups binary-search an offset
+ * index, O(log n) like the live list. The file uses the machine's
+ * native byte order, like skiplist_serialize. */
+
+struct skiplist_m;
+
+/* Produce KEY and VALUE as byte ranges for the compact file. The
+ * buffers only need to stay valid until the callback returns; a
+ * zero-length value (or key) is fine. Return false to abort. */
+typedef bool skiplist_m_encode_cb(void *key, void *value,
+    const void **key_buf, size_t *key_len,
+    const void **val_buf, size_t *val_len, void *udata);
+
+/* Compare two encoded keys. Should return <0, 0, or >0 like a cmp
+ * callback. The encoded order must match the live list's cmp order,
+ * or lookups against the file will miss. */
+typedef int skiplist_m_cmp_cb(const void *a, size_t a_len,
+    const void *b, size_t b_len);
+
+/* Write SL's pairs, in key order, to a compact file at PATH,
+ * encoding each pair with ENCODE (passed UDATA). Returns false on
+ * an I/O error, allocation failure, or aborting callback, in which
+ * case the partial file is removed. */
+bool skiplist_compact_to_file(struct skiplist *sl, const char *path,
+    skiplist_m_encode_cb *encode, void *udata);
+
+/* mmap a compact file for reading. CMP orders probe keys against
+ * the stored encoded keys; NULL compares bytewise (memcmp, shorter
+ * key first on a shared prefix), which matches strcmp/memcmp-ordered
+ * keys. Returns NULL if the file cannot be opened or is not a valid
+ * compact file. */
+struct skiplist_m *skiplist_m_open(const char *path,
+    skiplist_m_cmp_cb *cmp);
+
+/* How many pairs does the mapped skiplist contain? */
+size_t skiplist_m_count(const struct skiplist_m *m);
+
+/* Get the value stored under KEY (the first match, with duplicate
+ * keys). The returned bytes point into the mapping and stay valid
+ * until skiplist_m_close. NULL VALUE/VALUE_LEN are ignored.
+ * Returns whether the key was found. */
+bool skiplist_m_get(const struct skiplist_m *m,
+    const void *key, size_t key_len,
+    const void **value, size_t *value_len);
+
+/* Does the mapped skiplist contain KEY? */
+bool skiplist_m_member(const struct skiplist_m *m,
+    const void *key, size_t key_len);
+
+/* Get the INDEX'th pair in key order, O(1). NULL out-arguments are
+ * ignored. Returns false if INDEX is out of range. */
+bool skiplist_m_at_index(const struct skiplist_m *m, size_t index,
+    const void **key, size_t *key_len,
+    const void **value, size_t *value_len);
+
+/* Iteration callback; the byte ranges point into the mapping. */
+typedef enum skiplist_iter_res skiplist_m_iter_cb(const void *key,
+    size_t key_len, const void *value, size_t value_len, void *udata);
+
+/* Iterate over the pairs in ascending key order, or starting with
+ * the first key >= KEY. */
+void skiplist_m_iter(const struct skiplist_m *m,
+    skiplist_m_iter_cb *cb, void *udata);
+void skiplist_m_iter_from(const struct skiplist_m *m,
+    const void *key, size_t key_len,
+    skiplist_m_iter_cb *cb, void *udata);
+
+/* Unmap the file and free the handle. */
+void skiplist_m_close(struct skiplist_m *m);
+
+#endif
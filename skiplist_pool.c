@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2011-16 Scott Vokes <vokes.s@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "skiplist_config.h"
+#include "skiplist_pool.h"
+#include "skiplist_macros_internal.h"
+
+#define DEF_SLAB_SIZE (64 * 1024)
+
+/* Allocations are rounded up to a whole number of pointer-sized
+ * words; a free block's first word links it into its size bucket. */
+#define WORD sizeof(void *)
+#define WORDS(size) (((size) + WORD - 1) / WORD)
+
+struct pool_slab {
+    struct pool_slab *next;
+    /* SLAB_SIZE bytes of block storage follow. */
+};
+
+struct skiplist_pool {
+    size_t nbuckets;            /* free lists, indexed by block words */
+    size_t slab_size;
+    struct pool_slab *slabs;
+    uint8_t *bump;              /* unused space in the newest slab */
+    size_t bump_avail;
+    void *buckets[];
+};
+
+struct skiplist_pool *skiplist_pool_new(uint8_t max_height,
+        size_t slab_size) {
+    if (max_height == 0) { max_height = SKIPLIST_MAX_HEIGHT; }
+    if (slab_size == 0) { slab_size = DEF_SLAB_SIZE; }
+
+    /* The largest pooled block must cover a max_height node; anything
+     * larger falls through to malloc. The node header is at most a
+     * few words, so be generous rather than depending on the exact
+     * (private) layout of struct skiplist_node. */
+    size_t max_block = 4 * WORD + (max_height + 1) * WORD;
+    if (slab_size < max_block) { slab_size = max_block; }
+    size_t nbuckets = WORDS(max_block) + 1;
+
+    struct skiplist_pool *p = malloc(sizeof(*p)
+        + nbuckets * sizeof(void *));
+    if (p == NULL) { return NULL; }
+    p->nbuckets = nbuckets;
+    p->slab_size = slab_size;
+    p->slabs = NULL;
+    p->bump = NULL;
+    p->bump_avail = 0;
+    DO((int)nbuckets, p->buckets[i] = NULL);
+    return p;
+}
+
+static void *pool_alloc(struct skiplist_pool *p, size_t nsize) {
+    size_t words = WORDS(nsize);
+    if (words == 0) { words = 1; }
+    if (words >= p->nbuckets) {     /* oversized, not pooled */
+        return malloc(nsize);
+    }
+
+    void **head = &p->buckets[words];
+    if (*head) {                    /* recycle a freed block */
+        void *block = *head;
+        *head = *(void **)block;
+        return block;
+    }
+
+    if (p->bump_avail < words * WORD) {  /* need a fresh slab */
+        struct pool_slab *slab = malloc(sizeof(*slab) + p->slab_size);
+        if (slab == NULL) { return NULL; }
+        slab->next = p->slabs;
+        p->slabs = slab;
+        p->bump = (uint8_t *)(slab + 1);
+        p->bump_avail = p->slab_size;
+    }
+
+    void *block = p->bump;
+    p->bump += words * WORD;
+    p->bump_avail -= words * WORD;
+    return block;
+}
+
+static void pool_free_block(struct skiplist_pool *p,
+        void *block, size_t osize) {
+    size_t words = WORDS(osize);
+    if (words == 0) { words = 1; }
+    if (words >= p->nbuckets) {     /* oversized, not pooled */
+        free(block);
+        return;
+    }
+    *(void **)block = p->buckets[words];
+    p->buckets[words] = block;
+}
+
+void *skiplist_pool_cb(void *ptr, size_t osize, size_t nsize, void *udata) {
+    struct skiplist_pool *p = (struct skiplist_pool *)udata;
+    assert(p);
+    if (ptr) {
+        assert(nsize == 0);
+        pool_free_block(p, ptr, osize);
+        return NULL;
+    } else {
+        assert(osize == 0);
+        return pool_alloc(p, nsize);
+    }
+}
+
+void skiplist_pool_free(struct skiplist_pool *p) {
+    assert(p);
+    struct pool_slab *slab = p->slabs;
+    while (slab) {
+        struct pool_slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    free(p);
+}
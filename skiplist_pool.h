@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2011-16 Scott Vokes <vokes.s@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SKIPLIST_POOL_H
+#define SKIPLIST_POOL_H
+
+#include "skiplist.h"
+
+/* A pooled allocator for skiplists. Nodes are carved out of large
+ * slabs and recycled through per-size free lists, so delete/insert
+ * churn does not go through malloc/free for every node. Under heavy
+ * churn this avoids both allocator overhead and the fragmentation
+ * caused by variable-height nodes.
+ *
+ * The pool is not thread-safe; use one pool per skiplist (or per
+ * thread). All memory handed out by the pool is only reclaimed when
+ * the whole pool is freed. */
+struct skiplist_pool;
+
+/* Create a pool for a skiplist whose nodes have at most MAX_HEIGHT
+ * levels, carving allocations out of slabs of SLAB_SIZE bytes.
+ * A SLAB_SIZE of 0 picks a reasonable default. A MAX_HEIGHT of 0
+ * uses SKIPLIST_MAX_HEIGHT. Returns NULL on error.
+ *
+ * Use it by passing skiplist_pool_cb as the alloc callback and the
+ * pool as its udata:
+ *
+ *     struct skiplist_pool *p = skiplist_pool_new(0, 0);
+ *     struct skiplist *sl = skiplist_new(cmp, skiplist_pool_cb, p);
+ */
+struct skiplist_pool *skiplist_pool_new(uint8_t max_height,
+    size_t slab_size);
+
+/* A skiplist_alloc_cb backed by a pool; udata must be the pool. */
+void *skiplist_pool_cb(void *p, size_t osize, size_t nsize, void *udata);
+
+/* Free the pool and all of its slabs. Everything allocated from the
+ * pool becomes invalid, so free (or abandon) the skiplist first. */
+void skiplist_pool_free(struct skiplist_pool *p);
+
+#endif
@@ -0,0 +1,396 @@
+/* Range-sharded skiplist container: one skiplist plus one mutex per
+ * shard, shards split by key range so they concatenate into global
+ * order. See skiplist_sharded.h for the API. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <pthread.h>
+
+#include "skiplist_config.h"
+#include "skiplist_sharded.h"
+
+struct sharded_shard {
+    struct skiplist *sl;
+    pthread_mutex_t lock;
+};
+
+struct skiplist_sharded {
+    skiplist_cmp_cb *cmp;
+    skiplist_alloc_cb *alloc;
+    void *alloc_udata;
+    size_t n_shards;
+    void **splits;              /* n_shards - 1 ascending keys */
+    struct sharded_shard *shards;
+};
+
+static void *def_alloc(void *p,
+        size_t osize, size_t nsize, void *udata) {
+    (void)udata;
+    (void)osize;
+    if (p) {
+        assert(nsize == 0);
+        free(p);
+        return NULL;
+    } else {
+        assert(osize == 0);
+        return malloc(nsize);
+    }
+}
+
+/* The shard owning KEY: the number of split keys <= KEY, found by
+ * binary search. */
+static size_t shard_for(struct skiplist_sharded *ssl, void *key) {
+    size_t lo = 0, hi = ssl->n_shards - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ssl->cmp(key, ssl->splits[mid]) >= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+struct skiplist_sharded *skiplist_sharded_new(skiplist_cmp_cb *cmp,
+        skiplist_alloc_cb *alloc, void *alloc_udata,
+        size_t n_shards, void **split_keys) {
+    if (cmp == NULL || n_shards == 0) { return NULL; }
+    if (n_shards > 1 && split_keys == NULL) { return NULL; }
+    if (alloc == NULL) { alloc = def_alloc; }
+    for (size_t i = 0; i + 2 < n_shards; i++) {
+        if (cmp(split_keys[i], split_keys[i + 1]) >= 0) {
+            return NULL;        /* splits out of order */
+        }
+    }
+
+    struct skiplist_sharded *ssl = alloc(NULL, 0,
+        sizeof(*ssl), alloc_udata);
+    if (ssl == NULL) { return NULL; }
+    ssl->cmp = cmp;
+    ssl->alloc = alloc;
+    ssl->alloc_udata = alloc_udata;
+    ssl->n_shards = n_shards;
+    ssl->splits = NULL;
+    ssl->shards = alloc(NULL, 0,
+        n_shards * sizeof(*ssl->shards), alloc_udata);
+    if (ssl->shards == NULL) { goto fail; }
+    memset(ssl->shards, 0, n_shards * sizeof(*ssl->shards));
+    if (n_shards > 1) {
+        ssl->splits = alloc(NULL, 0,
+            (n_shards - 1) * sizeof(*ssl->splits), alloc_udata);
+        if (ssl->splits == NULL) { goto fail; }
+        memcpy(ssl->splits, split_keys,
+            (n_shards - 1) * sizeof(*ssl->splits));
+    }
+
+    for (size_t i = 0; i < n_shards; i++) {
+        struct skiplist *sl = skiplist_new(cmp, alloc, alloc_udata);
+        if (sl == NULL) { goto fail; }
+        /* Each shard draws heights from its own PRNG, so parallel
+         * writers never meet in random()'s global lock. */
+        skiplist_set_seed_local(sl, (uint64_t)i + 1);
+        ssl->shards[i].sl = sl;
+        if (0 != pthread_mutex_init(&ssl->shards[i].lock, NULL)) {
+            skiplist_free(sl, NULL, NULL);
+            ssl->shards[i].sl = NULL;
+            goto fail;
+        }
+    }
+    return ssl;
+
+fail:
+    if (ssl->shards) {
+        for (size_t i = 0; i < n_shards; i++) {
+            if (ssl->shards[i].sl) {
+                pthread_mutex_destroy(&ssl->shards[i].lock);
+                skiplist_free(ssl->shards[i].sl, NULL, NULL);
+            }
+        }
+        alloc(ssl->shards, n_shards * sizeof(*ssl->shards),
+            0, alloc_udata);
+    }
+    if (ssl->splits) {
+        alloc(ssl->splits, (n_shards - 1) * sizeof(*ssl->splits),
+            0, alloc_udata);
+    }
+    alloc(ssl, sizeof(*ssl), 0, alloc_udata);
+    return NULL;
+}
+
+bool skiplist_sharded_add(struct skiplist_sharded *ssl,
+        void *key, void *value) {
+    assert(ssl);
+    struct sharded_shard *s = &ssl->shards[shard_for(ssl, key)];
+    pthread_mutex_lock(&s->lock);
+    bool res = skiplist_add(s->sl, key, value);
+    pthread_mutex_unlock(&s->lock);
+    return res;
+}
+
+bool skiplist_sharded_set(struct skiplist_sharded *ssl,
+        void *key, void *value, void **old) {
+    assert(ssl);
+    struct sharded_shard *s = &ssl->shards[shard_for(ssl, key)];
+    pthread_mutex_lock(&s->lock);
+    bool res = skiplist_set(s->sl, key, value, old);
+    pthread_mutex_unlock(&s->lock);
+    return res;
+}
+
+bool skiplist_sharded_get(struct skiplist_sharded *ssl,
+        void *key, void **value) {
+    assert(ssl);
+    struct sharded_shard *s = &ssl->shards[shard_for(ssl, key)];
+    pthread_mutex_lock(&s->lock);
+    bool res = skiplist_get(s->sl, key, value);
+    pthread_mutex_unlock(&s->lock);
+    return res;
+}
+
+bool skiplist_sharded_member(struct skiplist_sharded *ssl, void *key) {
+    return skiplist_sharded_get(ssl, key, NULL);
+}
+
+bool skiplist_sharded_delete(struct skiplist_sharded *ssl,
+        void *key, void **value) {
+    assert(ssl);
+    struct sharded_shard *s = &ssl->shards[shard_for(ssl, key)];
+    pthread_mutex_lock(&s->lock);
+    bool res = skiplist_delete(s->sl, key, value);
+    pthread_mutex_unlock(&s->lock);
+    return res;
+}
+
+size_t skiplist_sharded_count(struct skiplist_sharded *ssl) {
+    assert(ssl);
+    size_t total = 0;
+    for (size_t i = 0; i < ssl->n_shards; i++) {
+        pthread_mutex_lock(&ssl->shards[i].lock);
+        total += skiplist_count(ssl->shards[i].sl);
+        pthread_mutex_unlock(&ssl->shards[i].lock);
+    }
+    return total;
+}
+
+/* Relay an iteration callback and remember whether it halted, so a
+ * halt inside one shard also stops the walk over later shards. */
+struct iter_relay {
+    skiplist_iter_cb *cb;
+    void *udata;
+    bool halted;
+};
+
+static enum skiplist_iter_res iter_relay_cb(void *key, void *value,
+        void *udata) {
+    struct iter_relay *r = (struct iter_relay *)udata;
+    enum skiplist_iter_res res = r->cb(key, value, r->udata);
+    if (res != SKIPLIST_ITER_CONTINUE) { r->halted = true; }
+    return res;
+}
+
+/* Walk SL from the first key >= KEY. skiplist_iter_from starts at
+ * an exact match, but the shard owning KEY must pick up at the
+ * following pair when the key is absent, so this seeks a cursor
+ * instead. Returns false on cursor allocation failure. */
+static bool shard_iter_geq(struct skiplist *sl, void *key,
+        skiplist_iter_cb *cb, void *udata) {
+    struct skiplist_cursor *c = skiplist_cursor_open(sl);
+    if (c == NULL) { return false; }
+    if (skiplist_cursor_seek(c, key)) {
+        void *k = NULL, *v = NULL;
+        while (skiplist_cursor_get(c, &k, &v)) {
+            if (cb(k, v, udata) != SKIPLIST_ITER_CONTINUE) { break; }
+            skiplist_cursor_next(c);
+        }
+    }
+    skiplist_cursor_close(c);
+    return true;
+}
+
+void skiplist_sharded_iter_from(struct skiplist_sharded *ssl,
+        void *key, skiplist_iter_cb *cb, void *udata) {
+    assert(ssl);
+    assert(cb);
+    struct iter_relay relay = { .cb = cb, .udata = udata };
+    size_t first = shard_for(ssl, key);
+    for (size_t i = first; i < ssl->n_shards; i++) {
+        struct sharded_shard *s = &ssl->shards[i];
+        bool ok = true;
+        pthread_mutex_lock(&s->lock);
+        if (i == first) {
+            /* Later shards only hold keys above KEY, so only the
+             * owning shard needs the >= positioning. */
+            ok = shard_iter_geq(s->sl, key, iter_relay_cb, &relay);
+        } else {
+            skiplist_iter(s->sl, iter_relay_cb, &relay);
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (relay.halted || !ok) { return; }
+    }
+}
+
+void skiplist_sharded_iter(struct skiplist_sharded *ssl,
+        skiplist_iter_cb *cb, void *udata) {
+    assert(ssl);
+    assert(cb);
+    struct iter_relay relay = { .cb = cb, .udata = udata };
+    for (size_t i = 0; i < ssl->n_shards; i++) {
+        struct sharded_shard *s = &ssl->shards[i];
+        pthread_mutex_lock(&s->lock);
+        skiplist_iter(s->sl, iter_relay_cb, &relay);
+        pthread_mutex_unlock(&s->lock);
+        if (relay.halted) { return; }
+    }
+}
+
+/* One shard's slice of a range query: the worker copies the
+ * matching pairs into a growable buffer under the shard lock, so
+ * the caller's callback later runs without holding any lock. */
+struct range_task {
+    struct skiplist_sharded *ssl;
+    struct sharded_shard *shard;
+    void *min_key;
+    void *max_key;
+    void **pairs;               /* ct keys, then ct values */
+    size_t ct;
+    size_t cap;                 /* pair capacity */
+    bool ok;
+};
+
+static bool range_task_grow(struct range_task *t) {
+    size_t ncap = t->cap == 0 ? 64 : 2 * t->cap;
+    struct skiplist_sharded *ssl = t->ssl;
+    void **np = ssl->alloc(NULL, 0,
+        2 * ncap * sizeof(*np), ssl->alloc_udata);
+    if (np == NULL) { return false; }
+    if (t->pairs) {
+        memcpy(np, t->pairs, t->ct * sizeof(*np));
+        memcpy(np + ncap, t->pairs + t->cap, t->ct * sizeof(*np));
+        ssl->alloc(t->pairs, 2 * t->cap * sizeof(*np),
+            0, ssl->alloc_udata);
+    }
+    t->pairs = np;
+    t->cap = ncap;
+    return true;
+}
+
+static enum skiplist_iter_res range_collect_cb(void *key, void *value,
+        void *udata) {
+    struct range_task *t = (struct range_task *)udata;
+    if (t->ssl->cmp(key, t->max_key) > 0) {
+        return SKIPLIST_ITER_HALT;      /* past the range */
+    }
+    if (t->ct == t->cap && !range_task_grow(t)) {
+        t->ok = false;
+        return SKIPLIST_ITER_HALT;
+    }
+    t->pairs[t->ct] = key;
+    t->pairs[t->cap + t->ct] = value;
+    t->ct++;
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+static void *range_worker(void *arg) {
+    struct range_task *t = (struct range_task *)arg;
+    pthread_mutex_lock(&t->shard->lock);
+    if (!shard_iter_geq(t->shard->sl, t->min_key,
+            range_collect_cb, t)) {
+        t->ok = false;
+    }
+    pthread_mutex_unlock(&t->shard->lock);
+    return NULL;
+}
+
+size_t skiplist_sharded_range(struct skiplist_sharded *ssl,
+        void *min_key, void *max_key,
+        skiplist_iter_cb *cb, void *udata) {
+    assert(ssl);
+    assert(cb);
+    if (ssl->cmp(min_key, max_key) > 0) { return 0; }
+    size_t s0 = shard_for(ssl, min_key);
+    size_t s1 = shard_for(ssl, max_key);
+    size_t n = s1 - s0 + 1;
+
+    struct range_task tasks[n];
+    for (size_t i = 0; i < n; i++) {
+        tasks[i] = (struct range_task) {
+            .ssl = ssl,
+            .shard = &ssl->shards[s0 + i],
+            .min_key = min_key,
+            .max_key = max_key,
+            .ok = true,
+        };
+    }
+
+    if (n == 1) {               /* nothing to fan out */
+        range_worker(&tasks[0]);
+    } else {
+        pthread_t tids[n];
+        for (size_t i = 0; i < n; i++) {
+            if (0 != pthread_create(&tids[i], NULL,
+                    range_worker, &tasks[i])) {
+                /* Out of threads; extract this slice ourselves. */
+                range_worker(&tasks[i]);
+                tids[i] = pthread_self();
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!pthread_equal(tids[i], pthread_self())) {
+                pthread_join(tids[i], NULL);
+            }
+        }
+    }
+
+    /* If any slice failed to extract (allocation failure in
+     * range_task_grow or the cursor open), deliver nothing: a
+     * silently truncated result would be indistinguishable from a
+     * complete one. */
+    bool failed = false;
+    for (size_t i = 0; i < n; i++) {
+        if (!tasks[i].ok) { failed = true; }
+    }
+
+    /* The shards partition by range, so delivering the slices in
+     * shard order is already ascending key order. */
+    size_t delivered = 0;
+    bool halted = false;
+    for (size_t i = 0; i < n; i++) {
+        struct range_task *t = &tasks[i];
+        for (size_t p = 0; !failed && !halted && p < t->ct; p++) {
+            if (cb(t->pairs[p], t->pairs[t->cap + p], udata)
+                != SKIPLIST_ITER_CONTINUE) {
+                halted = true;
+                delivered++;
+                break;
+            }
+            delivered++;
+        }
+        if (t->pairs) {
+            ssl->alloc(t->pairs, 2 * t->cap * sizeof(*t->pairs),
+                0, ssl->alloc_udata);
+        }
+    }
+    return failed ? (size_t)-1 : delivered;
+}
+
+size_t skiplist_sharded_free(struct skiplist_sharded *ssl,
+        skiplist_free_cb *cb, void *udata) {
+    assert(ssl);
+    size_t ct = 0;
+    for (size_t i = 0; i < ssl->n_shards; i++) {
+        pthread_mutex_destroy(&ssl->shards[i].lock);
+        ct += skiplist_free(ssl->shards[i].sl, cb, udata);
+    }
+    ssl->alloc(ssl->shards, ssl->n_shards * sizeof(*ssl->shards),
+        0, ssl->alloc_udata);
+    if (ssl->splits) {
+        ssl->alloc(ssl->splits,
+            (ssl->n_shards - 1) * sizeof(*ssl->splits),
+            0, ssl->alloc_udata);
+    }
+    ssl->alloc(ssl, sizeof(*ssl), 0, ssl->alloc_udata);
+    return ct;
+}
@@ -0,0 +1,98 @@
+#ifndef SKIPLIST_SHARDED_H
+#define SKIPLIST_SHARDED_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "skiplist.h"
+
+/* A sharded skiplist container: the key space is partitioned by
+ * RANGE across N independent skiplists, each guarded by its own
+ * mutex, so writers to different parts of the key space never
+ * contend. Because the partitioning is by range rather than by
+ * hash, the shards concatenate into the global key order, and a
+ * range query is simply the matching slice of each involved shard
+ * -- skiplist_sharded_range extracts those slices on one worker
+ * thread per shard and delivers the results in ascending key
+ * order.
+ *
+ * The shard boundaries are fixed at creation: shard 0 holds keys
+ * below the first split key, shard i keys in [split[i-1], split[i]),
+ * the last shard everything from the final split key up. Choosing
+ * splits that spread the workload is the caller's problem.
+ *
+ * The single-key operations and skiplist_sharded_range are safe to
+ * call from multiple threads concurrently. The whole-container
+ * operations (iter, free) lock one shard at a time, so they see
+ * each shard atomically but not the container as a whole. */
+
+struct skiplist_sharded;
+
+/* Create a sharded skiplist with N_SHARDS shards, partitioned by
+ * the N_SHARDS - 1 ascending SPLIT_KEYS, which must remain valid
+ * for the container's lifetime. CMP and the allocation callback are
+ * as in skiplist_new; the allocation callback must be safe to call
+ * from multiple threads. Returns NULL on allocation failure, or if
+ * the split keys are not in strictly ascending order. */
+struct skiplist_sharded *skiplist_sharded_new(skiplist_cmp_cb *cmp,
+    skiplist_alloc_cb *alloc, void *alloc_udata,
+    size_t n_shards, void **split_keys);
+
+/* Associate KEY with VALUE in the owning shard.
+ * Duplicate keys are fine. Returns false on allocation failure. */
+bool skiplist_sharded_add(struct skiplist_sharded *ssl,
+    void *key, void *value);
+
+/* Associate KEY with VALUE, replacing the value if the key is
+ * already present; the old value is returned through OLD (NULL when
+ * the key is new), as in skiplist_set. Returns false on allocation
+ * failure. */
+bool skiplist_sharded_set(struct skiplist_sharded *ssl,
+    void *key, void *value, void **old);
+
+/* Get the value associated with KEY. If the key is found and VALUE
+ * is non-NULL, it will be written into *VALUE.
+ * Returns whether the key was found. */
+bool skiplist_sharded_get(struct skiplist_sharded *ssl,
+    void *key, void **value);
+
+/* Does the container have an association for KEY? */
+bool skiplist_sharded_member(struct skiplist_sharded *ssl, void *key);
+
+/* Delete the first association for KEY. If found and VALUE is
+ * non-NULL, the old value will be written to *VALUE.
+ * Returns whether the key was found. */
+bool skiplist_sharded_delete(struct skiplist_sharded *ssl,
+    void *key, void **value);
+
+/* How many pairs does the container hold, across all shards? */
+size_t skiplist_sharded_count(struct skiplist_sharded *ssl);
+
+/* Iterate over all pairs in ascending key order, or starting with
+ * the first key >= KEY, visiting the shards in key order and
+ * holding each shard's lock while it is being walked. The callback
+ * type is shared with skiplist_iter. */
+void skiplist_sharded_iter(struct skiplist_sharded *ssl,
+    skiplist_iter_cb *cb, void *udata);
+void skiplist_sharded_iter_from(struct skiplist_sharded *ssl,
+    void *key, skiplist_iter_cb *cb, void *udata);
+
+/* Collect every pair with MIN_KEY <= key <= MAX_KEY, extracting the
+ * matching slice of each involved shard on its own worker thread,
+ * then deliver the pairs to CB in ascending key order. Each shard
+ * is only locked while its slice is copied out, not while the
+ * callback runs. Returns the number of pairs delivered (a halting
+ * callback stops the delivery, not the extraction), or (size_t)-1
+ * if extracting any shard's slice failed -- e.g. on allocation
+ * failure -- in which case no pairs are delivered at all. */
+size_t skiplist_sharded_range(struct skiplist_sharded *ssl,
+    void *min_key, void *max_key, skiplist_iter_cb *cb, void *udata);
+
+/* Free the container and all shards. If CB is non-NULL, it will be
+ * called on every key/value pair. Returns the number of pairs
+ * freed. No other thread may still be using the container. */
+size_t skiplist_sharded_free(struct skiplist_sharded *ssl,
+    skiplist_free_cb *cb, void *udata);
+
+#endif
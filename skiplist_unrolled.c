@@ -0,0 +1,373 @@
+/* Unrolled skiplist variant: blocks of up to SKIPLIST_UNROLL_B
+ * sorted pairs per level-0 node, towers only per block.
+ * See skiplist_unrolled.h for the API. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "skiplist_config.h"
+#include "skiplist_unrolled.h"
+#include "skiplist_macros_internal.h"
+
+struct skiplist_u_node {
+    int h;
+    int n;                      /* pairs used */
+    void *k[SKIPLIST_UNROLL_B];
+    void *v[SKIPLIST_UNROLL_B];
+    struct skiplist_u_node *next[];
+};
+
+struct skiplist_u {
+    size_t count;
+    struct skiplist_u_node *head;
+    skiplist_cmp_cb *cmp;
+    skiplist_alloc_cb *alloc;
+    void *alloc_udata;
+};
+
+/* Sentinel. */
+static struct skiplist_u_node U_SENTINEL = { .h = 0 };
+#define IS_SENTINEL(n) (n == &U_SENTINEL)
+
+#ifndef SKIPLIST_GEN_HEIGHT
+uint8_t SKIPLIST_GEN_HEIGHT(void);  /* defined in skiplist.c */
+#endif
+
+static void *def_alloc(void *p,
+        size_t osize, size_t nsize, void *udata) {
+    (void)udata;
+    (void)osize;
+    if (p) {
+        assert(nsize == 0);
+        free(p);
+        return NULL;
+    } else {
+        assert(osize == 0);
+        return malloc(nsize);
+    }
+}
+
+static size_t node_size_u(uint8_t height) {
+    return sizeof(struct skiplist_u_node) +
+      height * sizeof(struct skiplist_u_node *);
+}
+
+/* Allocate an empty block. Returns NULL on failure. */
+static struct skiplist_u_node *node_alloc_u(struct skiplist_u *sl,
+        uint8_t height) {
+    assert(height > 0);
+    assert(height <= SKIPLIST_MAX_HEIGHT);
+    struct skiplist_u_node *n = sl->alloc(NULL, 0,
+        node_size_u(height), sl->alloc_udata);
+    if (n == NULL) { return NULL; }
+    n->h = height;
+    n->n = 0;
+    DO(height, n->next[i] = &U_SENTINEL);
+    return n;
+}
+
+static void node_free_u(struct skiplist_u *sl,
+        struct skiplist_u_node *n) {
+    sl->alloc(n, node_size_u(n->h), 0, sl->alloc_udata);
+}
+
+struct skiplist_u *skiplist_u_new(skiplist_cmp_cb *cmp,
+        skiplist_alloc_cb *alloc, void *alloc_udata) {
+    if (cmp == NULL) { return NULL; }
+    if (alloc == NULL) { alloc = def_alloc; }
+
+    struct skiplist_u *sl = alloc(NULL, 0, sizeof(*sl), alloc_udata);
+    if (sl) {
+        sl->count = 0;
+        sl->cmp = cmp;
+        sl->alloc = alloc;
+        sl->alloc_udata = alloc_udata;
+
+        struct skiplist_u_node *head = node_alloc_u(sl, 1);
+        if (head == NULL) {
+            alloc(sl, sizeof(*sl), 0, alloc_udata);
+            return NULL;
+        }
+        sl->head = head;
+    }
+    return sl;
+}
+
+/* Collect the rightmost block at each level whose first key is
+ * <= KEY (or < KEY, when STRICT); prevs[0] is the block that should
+ * contain KEY, or the head if KEY sorts before every block. Blocks'
+ * first keys are strictly increasing, since keys are unique. */
+static void init_prevs_u(struct skiplist_u *sl, void *key, bool strict,
+        struct skiplist_u_node **prevs) {
+    struct skiplist_u_node *cur = sl->head;
+    for (int lvl = sl->head->h - 1; lvl >= 0; lvl--) {
+        for (;;) {
+            struct skiplist_u_node *next = cur->next[lvl];
+            if (IS_SENTINEL(next)) { break; }
+            int res = sl->cmp(next->k[0], key);
+            if (res < 0 || (!strict && res == 0)) {
+                cur = next;
+            } else {
+                break;
+            }
+        }
+        prevs[lvl] = cur;
+    }
+}
+
+/* Find KEY's position within block B: the index of the first pair
+ * with a key >= KEY (which is B->n if every key is smaller). */
+static int block_search(struct skiplist_u *sl,
+        struct skiplist_u_node *b, void *key, bool *found) {
+    int idx = 0;
+    *found = false;
+    while (idx < b->n) {
+        int res = sl->cmp(b->k[idx], key);
+        if (res == 0) { *found = true; break; }
+        if (res > 0) { break; }
+        idx++;
+    }
+    return idx;
+}
+
+static bool grow_head_u(struct skiplist_u *sl,
+        struct skiplist_u_node *nn) {
+    struct skiplist_u_node *old_head = sl->head;
+    struct skiplist_u_node *new_head = node_alloc_u(sl, nn->h);
+    if (new_head == NULL) { return false; }
+    DO(old_head->h, new_head->next[i] = old_head->next[i]);
+    for (int i = old_head->h; i < new_head->h; i++) {
+        new_head->next[i] = nn;
+    }
+    sl->head = new_head;
+    node_free_u(sl, old_head);
+    return true;
+}
+
+bool skiplist_u_add(struct skiplist_u *sl, void *key, void *value) {
+    assert(sl);
+    struct skiplist_u_node *head = sl->head;
+    int cur_height = head->h;
+    struct skiplist_u_node *prevs[cur_height];
+    init_prevs_u(sl, key, false, prevs);
+
+    struct skiplist_u_node *leaf = prevs[0];
+    if (leaf == head) {
+        /* KEY sorts before every block; prepend into the first one. */
+        leaf = head->next[0];
+    }
+
+    if (IS_SENTINEL(leaf)) {    /* empty list: create the first block */
+        struct skiplist_u_node *nn = node_alloc_u(sl,
+            SKIPLIST_GEN_HEIGHT());
+        if (nn == NULL) { return false; }
+        nn->k[0] = key;
+        nn->v[0] = value;
+        nn->n = 1;
+        if (nn->h > cur_height) {
+            if (!grow_head_u(sl, nn)) { return false; }
+            DO(cur_height, if (prevs[i] == /* old */ head)
+                               prevs[i] = sl->head);
+            head = sl->head;
+        }
+        int minH = nn->h < cur_height ? nn->h : cur_height;
+        for (int i = 0; i < minH; i++) {
+            nn->next[i] = prevs[i]->next[i];
+            prevs[i]->next[i] = nn;
+        }
+        sl->count++;
+        return true;
+    }
+
+    bool found = false;
+    int idx = block_search(sl, leaf, key, &found);
+    if (found) {                /* keys are unique: replace value */
+        leaf->v[idx] = value;
+        return true;
+    }
+
+    if (leaf->n < SKIPLIST_UNROLL_B) {
+        memmove(&leaf->k[idx + 1], &leaf->k[idx],
+            (leaf->n - idx) * sizeof(void *));
+        memmove(&leaf->v[idx + 1], &leaf->v[idx],
+            (leaf->n - idx) * sizeof(void *));
+        leaf->k[idx] = key;
+        leaf->v[idx] = value;
+        leaf->n++;
+        sl->count++;
+        return true;
+    }
+
+    /* The block is full: split the upper half (plus the new pair,
+     * wherever it lands) into a new block linked right after it. */
+    struct skiplist_u_node *nn = node_alloc_u(sl, SKIPLIST_GEN_HEIGHT());
+    if (nn == NULL) { return false; }
+    if (nn->h > cur_height) {
+        if (!grow_head_u(sl, nn)) {
+            node_free_u(sl, nn);
+            return false;
+        }
+        DO(cur_height, if (prevs[i] == /* old */ head)
+                           prevs[i] = sl->head);
+        head = sl->head;
+    }
+
+    void *tk[SKIPLIST_UNROLL_B + 1];
+    void *tv[SKIPLIST_UNROLL_B + 1];
+    memcpy(tk, leaf->k, idx * sizeof(void *));
+    memcpy(tv, leaf->v, idx * sizeof(void *));
+    tk[idx] = key;
+    tv[idx] = value;
+    memcpy(&tk[idx + 1], &leaf->k[idx],
+        (SKIPLIST_UNROLL_B - idx) * sizeof(void *));
+    memcpy(&tv[idx + 1], &leaf->v[idx],
+        (SKIPLIST_UNROLL_B - idx) * sizeof(void *));
+
+    int total = SKIPLIST_UNROLL_B + 1;
+    int keep = total / 2;
+    memcpy(leaf->k, tk, keep * sizeof(void *));
+    memcpy(leaf->v, tv, keep * sizeof(void *));
+    leaf->n = keep;
+    memcpy(nn->k, &tk[keep], (total - keep) * sizeof(void *));
+    memcpy(nn->v, &tv[keep], (total - keep) * sizeof(void *));
+    nn->n = total - keep;
+
+    /* Level 0 goes right after the split block; the upper levels go
+     * between the search prevs and their successors, except where a
+     * prev still points at the split block itself. */
+    nn->next[0] = leaf->next[0];
+    leaf->next[0] = nn;
+    int minH = nn->h < cur_height ? nn->h : cur_height;
+    for (int i = 1; i < minH; i++) {
+        struct skiplist_u_node *p = prevs[i];
+        if (p->next[i] == leaf) { p = leaf; }   /* nn goes after leaf */
+        nn->next[i] = p->next[i];
+        p->next[i] = nn;
+    }
+    sl->count++;
+    return true;
+}
+
+bool skiplist_u_get(struct skiplist_u *sl, void *key, void **value) {
+    assert(sl);
+    struct skiplist_u_node *prevs[sl->head->h];
+    init_prevs_u(sl, key, false, prevs);
+    struct skiplist_u_node *leaf = prevs[0];
+    if (leaf == sl->head) { return false; }
+    bool found = false;
+    int idx = block_search(sl, leaf, key, &found);
+    if (!found) { return false; }
+    if (value) { *value = leaf->v[idx]; }
+    return true;
+}
+
+bool skiplist_u_member(struct skiplist_u *sl, void *key) {
+    return skiplist_u_get(sl, key, NULL);
+}
+
+bool skiplist_u_delete(struct skiplist_u *sl, void *key, void **value) {
+    assert(sl);
+    struct skiplist_u_node *head = sl->head;
+    int cur_height = head->h;
+    struct skiplist_u_node *prevs[cur_height];
+    init_prevs_u(sl, key, false, prevs);
+
+    struct skiplist_u_node *leaf = prevs[0];
+    if (leaf == head) { return false; }     /* key < every block */
+    bool found = false;
+    int idx = block_search(sl, leaf, key, &found);
+    if (!found) { return false; }
+
+    void *k0 = leaf->k[0];      /* before it's shifted away */
+    if (value) { *value = leaf->v[idx]; }
+    memmove(&leaf->k[idx], &leaf->k[idx + 1],
+        (leaf->n - idx - 1) * sizeof(void *));
+    memmove(&leaf->v[idx], &leaf->v[idx + 1],
+        (leaf->n - idx - 1) * sizeof(void *));
+    leaf->n--;
+    sl->count--;
+    if (leaf->n > 0) { return true; }
+
+    /* The block is empty: unlink it. A strict search on its first
+     * key finds its exact predecessors, since first keys are
+     * strictly increasing. */
+    struct skiplist_u_node *lprevs[cur_height];
+    init_prevs_u(sl, k0, true, lprevs);
+    DO(leaf->h,
+        assert(lprevs[i]->next[i] == leaf);
+        lprevs[i]->next[i] = leaf->next[i]);
+    node_free_u(sl, leaf);
+    return true;
+}
+
+size_t skiplist_u_count(struct skiplist_u *sl) {
+    assert(sl);
+    return sl->count;
+}
+
+bool skiplist_u_empty(struct skiplist_u *sl) {
+    return (skiplist_u_count(sl) == 0);
+}
+
+static void walk_blocks(struct skiplist_u_node *cur, int idx,
+        skiplist_iter_cb *cb, void *udata) {
+    while (!IS_SENTINEL(cur)) {
+        for (; idx < cur->n; idx++) {
+            if (cb(cur->k[idx], cur->v[idx], udata)
+                != SKIPLIST_ITER_CONTINUE) {
+                return;
+            }
+        }
+        idx = 0;
+        cur = cur->next[0];
+    }
+}
+
+void skiplist_u_iter(struct skiplist_u *sl,
+        skiplist_iter_cb *cb, void *udata) {
+    assert(sl);
+    assert(cb);
+    walk_blocks(sl->head->next[0], 0, cb, udata);
+}
+
+void skiplist_u_iter_from(struct skiplist_u *sl, void *key,
+        skiplist_iter_cb *cb, void *udata) {
+    assert(sl);
+    assert(cb);
+    struct skiplist_u_node *prevs[sl->head->h];
+    init_prevs_u(sl, key, false, prevs);
+    struct skiplist_u_node *leaf = prevs[0];
+    int idx = 0;
+    if (leaf == sl->head) {
+        leaf = sl->head->next[0];
+    } else {
+        bool found = false;
+        idx = block_search(sl, leaf, key, &found);
+        if (idx == leaf->n) {   /* every key here is smaller */
+            leaf = leaf->next[0];
+            idx = 0;
+        }
+    }
+    walk_blocks(leaf, idx, cb, udata);
+}
+
+size_t skiplist_u_free(struct skiplist_u *sl,
+        skiplist_free_cb *cb, void *udata) {
+    assert(sl);
+    struct skiplist_u_node *cur = sl->head->next[0];
+    size_t ct = 0;
+    while (!IS_SENTINEL(cur)) {
+        struct skiplist_u_node *doomed = cur;
+        cur = cur->next[0];
+        for (int i = 0; i < doomed->n; i++) {
+            if (cb) { cb(doomed->k[i], doomed->v[i], udata); }
+            ct++;
+        }
+        node_free_u(sl, doomed);
+    }
+    node_free_u(sl, sl->head);
+    sl->alloc(sl, sizeof(*sl), 0, sl->alloc_udata);
+    return ct;
+}
@@ -0,0 +1,64 @@
+#ifndef SKIPLIST_UNROLLED_H
+#define SKIPLIST_UNROLLED_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "skiplist.h"
+
+/* An "unrolled" skiplist variant: each level-0 node is a block
+ * holding a small sorted array of up to SKIPLIST_UNROLL_B key/value
+ * pairs (see skiplist_config.h), with towers only every block. This
+ * cuts the node count and per-pair pointer overhead by roughly the
+ * block size, and makes iteration touch one cache line per block
+ * instead of one per pair, so scans become mostly sequential reads.
+ *
+ * Unlike struct skiplist, keys are unique here: adding a key that is
+ * already present replaces its value. The callback types are shared
+ * with skiplist.h. */
+
+struct skiplist_u;
+
+/* Create a new unrolled skiplist, returns NULL on error.
+ * The arguments are as in skiplist_new. */
+struct skiplist_u *skiplist_u_new(skiplist_cmp_cb *cmp,
+    skiplist_alloc_cb *alloc, void *alloc_udata);
+
+/* Associate KEY with VALUE, replacing the value if the key is
+ * already present. Returns false on allocation failure. */
+bool skiplist_u_add(struct skiplist_u *sl, void *key, void *value);
+
+/* Get the value associated with KEY. If the key is found and VALUE
+ * is non-NULL, it will be written into *VALUE.
+ * Returns whether the key was found. */
+bool skiplist_u_get(struct skiplist_u *sl, void *key, void **value);
+
+/* Does the skiplist contain KEY? */
+bool skiplist_u_member(struct skiplist_u *sl, void *key);
+
+/* Delete the association for KEY. If found and VALUE is non-NULL,
+ * the old value will be written to *VALUE.
+ * Returns whether the key was found. */
+bool skiplist_u_delete(struct skiplist_u *sl, void *key, void **value);
+
+/* How many pairs does the skiplist contain? */
+size_t skiplist_u_count(struct skiplist_u *sl);
+
+/* Is the skiplist empty? */
+bool skiplist_u_empty(struct skiplist_u *sl);
+
+/* Iterate over the pairs in ascending key order, or starting with
+ * the first key >= KEY. The iteration callback type is shared with
+ * skiplist_iter. */
+void skiplist_u_iter(struct skiplist_u *sl,
+    skiplist_iter_cb *cb, void *udata);
+void skiplist_u_iter_from(struct skiplist_u *sl, void *key,
+    skiplist_iter_cb *cb, void *udata);
+
+/* Free the skiplist. If CB is non-NULL, it will be called on every
+ * key/value pair. Returns the number of pairs freed. */
+size_t skiplist_u_free(struct skiplist_u *sl,
+    skiplist_free_cb *cb, void *udata);
+
+#endif
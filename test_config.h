@@ -7,4 +7,12 @@
 
 #define SKIPLIST_DEBUG 1
 
+#define SKIPLIST_WIDTHS 1
+
+#define SKIPLIST_BACK_POINTERS 1
+
+#define SKIPLIST_FINGERPRINT 1
+
+#define SKIPLIST_STATS 1
+
 #endif
@@ -8,6 +8,12 @@
 
 #include "test_config.h"
 #include "skiplist.h"
+#include "skiplist_pool.h"
+#include "skiplist_unrolled.h"
+#include "skiplist_cmp.h"
+#include "skiplist_cow.h"
+#include "skiplist_mapped.h"
+#include "skiplist_sharded.h"
 #include "greatest.h"
 #include "test_alloc.h"
 
@@ -344,6 +350,49 @@ TEST set(void) {
     PASS();
 }
 
+static bool counter_update_cb(void *key, void **value, bool present,
+        void *udata) {
+    (void)key;
+    bool *create = (bool *)udata;
+    if (!present && !*create) { return false; }
+    *value = (void *) ((long) *value + 1);
+    return true;
+}
+
+/* skiplist_update bumps a counter value in place with one search,
+ * inserts through the callback when the key is absent, and leaves
+ * the skiplist unchanged when the callback declines. */
+TEST update_in_place(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    bool create = false;
+
+    /* Declined: an absent key stays absent. */
+    ASSERT_FALSE(skiplist_update(sl, (void *) 5L,
+            counter_update_cb, &create));
+    ASSERT_EQ_FMT((size_t)0, skiplist_count(sl), "%zd");
+
+    /* Upsert: the callback supplies the initial value (0 + 1). */
+    create = true;
+    const long limit = 100;
+    for (long i = 0; i < limit; i++) {
+        for (long hits = 0; hits <= i % 3; hits++) {
+            ASSERT(skiplist_update(sl, (void *) i,
+                    counter_update_cb, &create));
+        }
+    }
+    skiplist_debug(sl, NULL, NULL, NULL);
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl), "%zd");
+    for (long i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(sl, (void *) i, &v));
+        ASSERT_EQ(i % 3 + 1, (long) v);
+    }
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
 /* Set and delete in an empty skiplist, check invariants. */
 TEST trivial_delete(void) {
     struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
@@ -569,6 +618,1677 @@ TEST delete_all_end(void) {
     PASS();
 }
 
+/* Delete whole key ranges: interior, crossing the end, and empty. */
+TEST delete_range(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    const intptr_t limit = 1000;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) 1));
+    }
+
+    /* Ranges with no matching keys delete nothing. */
+    ASSERT_EQ_FMT((size_t)0, skiplist_delete_range(sl,
+            (void *) (intptr_t) -10, (void *) (intptr_t) -1,
+            NULL, NULL), "%zd");
+    ASSERT_EQ_FMT((size_t)0, skiplist_delete_range(sl,
+            (void *) limit, (void *) (2 * limit), NULL, NULL), "%zd");
+    ASSERT(skiplist_count(sl) == (size_t)limit);
+
+    /* An interior span; both boundaries are inclusive. */
+    int count = 0;
+    ASSERT_EQ_FMT((size_t)100, skiplist_delete_range(sl,
+            (void *) (intptr_t) 100, (void *) (intptr_t) 199,
+            inc_cb, &count), "%zd");
+    ASSERT(count == 100);
+    ASSERT(skiplist_count(sl) == (size_t)limit - 100);
+    ASSERT(skiplist_member(sl, (void *) (intptr_t) 99));
+    ASSERT(!skiplist_member(sl, (void *) (intptr_t) 100));
+    ASSERT(!skiplist_member(sl, (void *) (intptr_t) 199));
+    ASSERT(skiplist_member(sl, (void *) (intptr_t) 200));
+
+    /* A span overshooting the last key. */
+    ASSERT_EQ_FMT((size_t)100, skiplist_delete_range(sl,
+            (void *) (limit - 100), (void *) (2 * limit),
+            NULL, NULL), "%zd");
+    ASSERT(!skiplist_member(sl, (void *) (limit - 1)));
+    ASSERT(skiplist_member(sl, (void *) (limit - 101)));
+
+    /* Everything that's left. */
+    ASSERT_EQ_FMT((size_t)limit - 200, skiplist_delete_range(sl,
+            (void *) (intptr_t) 0, (void *) limit, NULL, NULL), "%zd");
+    ASSERT(skiplist_empty(sl));
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Rank queries through the span widths, which every update
+ * operation has to maintain: adds, deletes, pops, range-deletes. */
+TEST at_index(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    const intptr_t limit = 1000;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) (2 * i), (void *) i));
+    }
+    for (intptr_t i = 0; i < limit; i++) {
+        void *k = NULL, *v = NULL;
+        ASSERT(skiplist_at_index(sl, (size_t) i, &k, &v));
+        ASSERT_EQ(2 * i, (intptr_t) k);
+        ASSERT_EQ(i, (intptr_t) v);
+    }
+    ASSERT(!skiplist_at_index(sl, (size_t) limit, NULL, NULL));
+
+    /* Keys are 0,2,...,1998; knock holes in the keyspace with every
+     * kind of delete and check the ranks shift accordingly. */
+    ASSERT(skiplist_delete(sl, (void *) (intptr_t) 500, NULL));
+    ASSERT(skiplist_pop_first(sl, NULL, NULL));
+    ASSERT(skiplist_pop_last(sl, NULL, NULL));
+    ASSERT_EQ_FMT((size_t)51, skiplist_delete_range(sl,
+            (void *) (intptr_t) 100, (void *) (intptr_t) 200,
+            NULL, NULL), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    void *k = NULL;
+    ASSERT(skiplist_at_index(sl, 0, &k, NULL));
+    ASSERT_EQ(2, (intptr_t) k);
+    ASSERT(skiplist_at_index(sl, 48, &k, NULL));
+    ASSERT_EQ(98, (intptr_t) k);
+    ASSERT(skiplist_at_index(sl, 49, &k, NULL));
+    ASSERT_EQ(202, (intptr_t) k);
+    ASSERT(skiplist_at_index(sl, 197, &k, NULL));
+    ASSERT_EQ(498, (intptr_t) k);
+    ASSERT(skiplist_at_index(sl, 198, &k, NULL));
+    ASSERT_EQ(502, (intptr_t) k);
+    ASSERT(skiplist_at_index(sl, 945, &k, NULL));
+    ASSERT_EQ(1996, (intptr_t) k);
+    ASSERT(!skiplist_at_index(sl, 946, &k, NULL));
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Count keys in a range in O(log n), including duplicates. */
+TEST count_range(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    const size_t limit = 1000;
+    void **keys = test_malloc(limit * sizeof(void *));
+    ASSERT(keys);
+    for (size_t i = 0; i < limit; i++) { keys[i] = (void *) i; }
+    ASSERT(skiplist_load_sorted(sl, keys, NULL, limit));
+    test_free(keys, limit * sizeof(void *));
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    ASSERT_EQ_FMT(limit, skiplist_count_range(sl,
+            (void *) (intptr_t) 0, (void *) limit), "%zd");
+    ASSERT_EQ_FMT((size_t)100, skiplist_count_range(sl,
+            (void *) (intptr_t) 100, (void *) (intptr_t) 199), "%zd");
+    ASSERT_EQ_FMT((size_t)1, skiplist_count_range(sl,
+            (void *) (intptr_t) 7, (void *) (intptr_t) 7), "%zd");
+    ASSERT_EQ_FMT((size_t)0, skiplist_count_range(sl,
+            (void *) (intptr_t) 500, (void *) (intptr_t) 100), "%zd");
+    ASSERT_EQ_FMT((size_t)0, skiplist_count_range(sl,
+            (void *) limit, (void *) (2 * limit)), "%zd");
+
+    /* Duplicates count separately; replacing a value does not
+     * disturb the widths. */
+    ASSERT(skiplist_add(sl, (void *) (intptr_t) 600, NULL));
+    ASSERT(skiplist_add(sl, (void *) (intptr_t) 600, NULL));
+    ASSERT(skiplist_set(sl, (void *) (intptr_t) 600, NULL, NULL));
+    skiplist_debug(sl, NULL, NULL, NULL);
+    ASSERT_EQ_FMT((size_t)3, skiplist_count_range(sl,
+            (void *) (intptr_t) 600, (void *) (intptr_t) 600), "%zd");
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Bulk-load sorted numeric pairs and check they are all present,
+ * in order, and interchangeable with individually added pairs. */
+TEST load_sorted(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const size_t limit = 10000;
+    void **keys = test_malloc(limit * sizeof(void *));
+    ASSERT(keys);
+    for (size_t i = 0; i < limit; i++) { keys[i] = (void *) i; }
+
+    ASSERT(skiplist_load_sorted(sl, keys, keys, limit));
+    ASSERT(skiplist_count(sl) == limit);
+
+    for (size_t i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(sl, (void *) i, &v));
+        ASSERT(v == (void *) i);
+    }
+
+    /* Appending more sorted pairs after the fact also works. */
+    for (size_t i = 0; i < limit; i++) { keys[i] = (void *) (limit + i); }
+    ASSERT(skiplist_load_sorted(sl, keys, NULL, limit));
+    ASSERT(skiplist_count(sl) == 2 * limit);
+    ASSERT(skiplist_member(sl, (void *) (2 * limit - 1)));
+
+    test_free(keys, limit * sizeof(void *));
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Out-of-order input is a checked error: loading stops and
+ * the skiplist keeps the prefix added so far. */
+TEST load_sorted_rejects_unsorted(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    void *keys[] = { (void *) 1, (void *) 2, (void *) 0 };
+
+    ASSERT(!skiplist_load_sorted(sl, keys, NULL, 3));
+    ASSERT(skiplist_count(sl) == 2);
+    ASSERT(skiplist_member(sl, (void *) 1));
+    ASSERT(skiplist_member(sl, (void *) 2));
+    ASSERT(!skiplist_member(sl, (void *) 0));
+
+    /* Keys below the current last key are also rejected. */
+    ASSERT(!skiplist_load_sorted(sl, keys, NULL, 1));
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Walk the whole skiplist with a cursor and check the pairs come
+ * back sorted, with the same count as the callback iterator. */
+/* In-memory stream for the serialization tests. */
+struct stream_buf {
+    uint8_t *data;
+    size_t size;                /* bytes written */
+    size_t cap;
+    size_t rpos;                /* read position */
+};
+
+static bool sb_write(const void *buf, size_t len, void *udata) {
+    struct stream_buf *sb = (struct stream_buf *) udata;
+    if (sb->size + len > sb->cap) { return false; }
+    memcpy(&sb->data[sb->size], buf, len);
+    sb->size += len;
+    return true;
+}
+
+static bool sb_read(void *buf, size_t len, void *udata) {
+    struct stream_buf *sb = (struct stream_buf *) udata;
+    if (sb->rpos + len > sb->size) { return false; }
+    memcpy(buf, &sb->data[sb->rpos], len);
+    sb->rpos += len;
+    return true;
+}
+
+static bool intptr_encode(void *key, void *value,
+        skiplist_write_cb *write, void *udata) {
+    uintptr_t k = (uintptr_t) key, v = (uintptr_t) value;
+    return write(&k, sizeof(k), udata) && write(&v, sizeof(v), udata);
+}
+
+static bool intptr_decode(void **key, void **value,
+        skiplist_read_cb *read, void *udata) {
+    uintptr_t k = 0, v = 0;
+    if (!read(&k, sizeof(k), udata) || !read(&v, sizeof(v), udata)) {
+        return false;
+    }
+    *key = (void *) k;
+    *value = (void *) v;
+    return true;
+}
+
+/* Serialize a skiplist into a memory buffer and rebuild it. */
+TEST serialize_round_trip(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const intptr_t limit = 1000;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) (3 * i)));
+    }
+
+    struct stream_buf sb = { .cap = 64 + limit * 32 };
+    sb.data = test_malloc(sb.cap);
+    ASSERT(sb.data);
+    ASSERT(skiplist_serialize(sl, sb_write, intptr_encode, &sb));
+
+    struct skiplist *sl2 = skiplist_deserialize(sb_read, intptr_decode,
+        &sb, sl_longcmp, test_alloc, NULL);
+    ASSERT(sl2);
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl2), "%zd");
+    skiplist_debug(sl2, NULL, NULL, NULL);
+    for (intptr_t i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(sl2, (void *) i, &v));
+        ASSERT_EQ(3 * i, (intptr_t) v);
+    }
+
+    test_free(sb.data, sb.cap);
+    skiplist_free(sl, NULL, NULL);
+    skiplist_free(sl2, NULL, NULL);
+    PASS();
+}
+
+/* Corrupted or truncated streams are rejected cleanly. */
+TEST deserialize_rejects_garbage(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const intptr_t limit = 100;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+
+    struct stream_buf sb = { .cap = 64 + limit * 32 };
+    sb.data = test_malloc(sb.cap);
+    ASSERT(sb.data);
+    ASSERT(skiplist_serialize(sl, sb_write, intptr_encode, &sb));
+
+    /* Bad magic. */
+    sb.data[0] ^= 0xff;
+    sb.rpos = 0;
+    ASSERT_EQ(NULL, skiplist_deserialize(sb_read, intptr_decode, &sb,
+            sl_longcmp, test_alloc, NULL));
+    sb.data[0] ^= 0xff;
+
+    /* Truncated stream. */
+    size_t full = sb.size;
+    sb.size -= 5;
+    sb.rpos = 0;
+    ASSERT_EQ(NULL, skiplist_deserialize(sb_read, intptr_decode, &sb,
+            sl_longcmp, test_alloc, NULL));
+    sb.size = full;
+
+    /* Still valid once restored. */
+    sb.rpos = 0;
+    struct skiplist *sl2 = skiplist_deserialize(sb_read, intptr_decode,
+        &sb, sl_longcmp, test_alloc, NULL);
+    ASSERT(sl2);
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl2), "%zd");
+    skiplist_free(sl2, NULL, NULL);
+
+    test_free(sb.data, sb.cap);
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Exercise the search-finger API: a monotonic ingest, lookups with
+ * locality in both directions, and out-of-order adds that force the
+ * finger to climb back toward the head. */
+TEST finger_ops(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    struct skiplist_finger *f = skiplist_finger_new(sl);
+    ASSERT(f);
+
+    const long limit = 1000;
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_add_at(f, (void *) (2 * i), (void *) (3 * i)));
+    }
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    void *v = NULL;
+    ASSERT(skiplist_get_at(f, (void *) 500L, &v));
+    ASSERT_EQ(750L, (long) v);
+    ASSERT(skiplist_get_at(f, (void *) 510L, &v));  /* just ahead */
+    ASSERT_EQ(765L, (long) v);
+    ASSERT(skiplist_get_at(f, (void *) 490L, &v));  /* just behind */
+    ASSERT_EQ(735L, (long) v);
+    ASSERT_FALSE(skiplist_get_at(f, (void *) 491L, NULL));
+    ASSERT(skiplist_get_at(f, (void *) 0L, &v));    /* far left */
+    ASSERT_EQ(0L, (long) v);
+    ASSERT(skiplist_get_at(f, (void *) (2 * (limit - 1)), &v));
+    ASSERT_EQ(3 * (limit - 1), (long) v);           /* far right */
+
+    /* Out-of-order and duplicate adds still land correctly. */
+    ASSERT(skiplist_add_at(f, (void *) 501L, (void *) 501L));
+    ASSERT(skiplist_add_at(f, (void *) 245L, (void *) 245L));
+    ASSERT(skiplist_add_at(f, (void *) 245L, (void *) 245L));
+    ASSERT(skiplist_add_at(f, (void *) 9999L, (void *) 9999L));
+    ASSERT_EQ_FMT((size_t)limit + 4, skiplist_count(sl), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+    ASSERT(skiplist_member(sl, (void *) 501L));
+    ASSERT(skiplist_member(sl, (void *) 245L));
+    ASSERT(skiplist_member(sl, (void *) 9999L));
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_member(sl, (void *) (2 * i)));
+    }
+
+    /* Two read-only fingers can walk the list independently. */
+    struct skiplist_finger *f2 = skiplist_finger_new(sl);
+    ASSERT(f2);
+    ASSERT(skiplist_get_at(f2, (void *) 800L, &v));
+    ASSERT_EQ(1200L, (long) v);
+    ASSERT(skiplist_get_at(f, (void *) 400L, &v));
+    ASSERT_EQ(600L, (long) v);
+    ASSERT(skiplist_get_at(f2, (void *) 802L, &v));
+    ASSERT_EQ(1203L, (long) v);
+
+    skiplist_finger_free(f);
+    skiplist_finger_free(f2);
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Two lists with the same local seed and insertion sequence build
+ * identical structures (checked via their serialized streams, which
+ * include every node height); a different seed diverges. */
+TEST seed_local_deterministic(void) {
+    const intptr_t limit = 500;
+    struct skiplist *sls[3];
+    struct stream_buf sbs[3];
+    for (int li = 0; li < 3; li++) {
+        sls[li] = skiplist_new(sl_longcmp, test_alloc, NULL);
+        ASSERT(sls[li]);
+        skiplist_set_seed_local(sls[li], li == 2 ? 99 : 42);
+        for (intptr_t i = 0; i < limit; i++) {
+            intptr_t k = (i * 7919) % limit;
+            ASSERT(skiplist_add(sls[li], (void *) k, (void *) k));
+        }
+        skiplist_debug(sls[li], NULL, NULL, NULL);
+
+        sbs[li] = (struct stream_buf) { .cap = 64 + limit * 32 };
+        sbs[li].data = test_malloc(sbs[li].cap);
+        ASSERT(sbs[li].data);
+        ASSERT(skiplist_serialize(sls[li], sb_write, intptr_encode,
+                &sbs[li]));
+    }
+
+    ASSERT_EQ_FMT(sbs[0].size, sbs[1].size, "%zd");
+    ASSERT_EQ(0, memcmp(sbs[0].data, sbs[1].data, sbs[0].size));
+    ASSERT(sbs[0].size != sbs[2].size ||
+        0 != memcmp(sbs[0].data, sbs[2].data, sbs[0].size));
+
+    for (int li = 0; li < 3; li++) {
+        test_free(sbs[li].data, sbs[li].cap);
+        skiplist_free(sls[li], NULL, NULL);
+    }
+    PASS();
+}
+
+/* Floor and ceiling on even keys 0..998: exact hits, between-key
+ * probes, and probes beyond either end. */
+TEST floor_and_ceiling(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 500;
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) (2 * i), (void *) (3 * i)));
+    }
+
+    void *k = NULL, *v = NULL;
+    ASSERT(skiplist_ceiling(sl, (void *) 5L, &k, &v));
+    ASSERT_EQ(6L, (long) k);
+    ASSERT_EQ(9L, (long) v);
+    ASSERT(skiplist_floor(sl, (void *) 5L, &k, &v));
+    ASSERT_EQ(4L, (long) k);
+    ASSERT_EQ(6L, (long) v);
+
+    /* Exact hits return the key itself. */
+    ASSERT(skiplist_ceiling(sl, (void *) 400L, &k, NULL));
+    ASSERT_EQ(400L, (long) k);
+    ASSERT(skiplist_floor(sl, (void *) 400L, &k, NULL));
+    ASSERT_EQ(400L, (long) k);
+
+    /* The ends. */
+    ASSERT(skiplist_ceiling(sl, (void *) -10L, &k, NULL));
+    ASSERT_EQ(0L, (long) k);
+    ASSERT(skiplist_floor(sl, (void *) 99999L, &k, NULL));
+    ASSERT_EQ(2 * (limit - 1), (long) k);
+    ASSERT_FALSE(skiplist_floor(sl, (void *) -1L, &k, NULL));
+    ASSERT_FALSE(skiplist_ceiling(sl, (void *) 99999L, &k, NULL));
+
+    skiplist_free(sl, NULL, NULL);
+
+    /* Both fail on an empty skiplist. */
+    sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    ASSERT_FALSE(skiplist_floor(sl, (void *) 1L, NULL, NULL));
+    ASSERT_FALSE(skiplist_ceiling(sl, (void *) 1L, NULL, NULL));
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* A borrowed (pointer, length) view into a larger buffer, compared
+ * against owned NUL-terminated string keys without copying. */
+struct key_view {
+    const char *p;
+    size_t len;
+};
+
+static int view_strcmp(void *probe, void *key) {
+    struct key_view *kv = (struct key_view *) probe;
+    const char *s = (const char *) key;
+    int res = strncmp(kv->p, s, kv->len);
+    if (res != 0) { return res; }
+    /* The view matched a prefix: shorter sorts first. */
+    return s[kv->len] == '\0' ? 0 : -1;
+}
+
+static int long_probe_cmp(void *probe, void *key) {
+    long p = *(long *) probe, k = (long) key;
+    return p < k ? -1 : p > k ? 1 : 0;
+}
+
+struct probe_iter_env {
+    size_t count;
+    long first;
+};
+
+static enum skiplist_iter_res probe_iter_cb(void *key,
+        void *value, void *udata) {
+    (void)value;
+    struct probe_iter_env *env = (struct probe_iter_env *) udata;
+    if (env->count == 0) { env->first = (long) key; }
+    env->count++;
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+/* Lookups driven by a caller-supplied probe comparator: a borrowed
+ * (pointer, length) view finds owned string keys without
+ * materializing a NUL-terminated copy, and a pointer-to-long probe
+ * drives the _ex ceiling/floor/iter_from variants. */
+TEST probe_comparator_lookups(void) {
+    struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
+    ASSERT(sl);
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(sl, *w, *w));
+    }
+
+    /* "garlic" embedded in a larger buffer, not NUL-terminated. */
+    char buf[16];
+    memcpy(buf, "##garlic##", 10);
+    struct key_view view = { buf + 2, 6 };
+    void *v = NULL;
+    ASSERT(skiplist_get_ex(sl, &view, view_strcmp, &v));
+    ASSERT_STR_EQ("garlic", (char *) v);
+    ASSERT(skiplist_member_ex(sl, &view, view_strcmp));
+
+    struct key_view missing = { "zzz-not-here", 12 };
+    ASSERT_FALSE(skiplist_member_ex(sl, &missing, view_strcmp));
+    skiplist_free(sl, NULL, NULL);
+
+    /* Even keys 0..998, probed through a pointer to long. */
+    sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    for (long i = 0; i < 500; i++) {
+        ASSERT(skiplist_add(sl, (void *) (2 * i), (void *) (2 * i)));
+    }
+    long probe = 5;
+    void *k = NULL;
+    ASSERT(skiplist_ceiling_ex(sl, &probe, long_probe_cmp, &k, NULL));
+    ASSERT_EQ(6L, (long) k);
+    ASSERT(skiplist_floor_ex(sl, &probe, long_probe_cmp, &k, NULL));
+    ASSERT_EQ(4L, (long) k);
+
+    probe = 400;
+    struct probe_iter_env env = { 0, -1 };
+    skiplist_iter_from_ex(sl, &probe, long_probe_cmp,
+        probe_iter_cb, &env);
+    ASSERT_EQ(400L, env.first);
+    ASSERT_EQ_FMT((size_t)300, env.count, "%zd");
+
+    /* Like skiplist_iter_from, an absent key iterates nothing. */
+    probe = 401;
+    env.count = 0;
+    skiplist_iter_from_ex(sl, &probe, long_probe_cmp,
+        probe_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)0, env.count, "%zd");
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Merging steals the source's nodes: counts and order hold, both
+ * lists stay valid, and duplicate keys across lists all survive. */
+TEST merge_lists(void) {
+    struct skiplist *a = skiplist_new(sl_longcmp, test_alloc, NULL);
+    struct skiplist *b = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(a);
+    ASSERT(b);
+    const long limit = 1000;
+    for (long i = 0; i < limit; i++) {
+        struct skiplist *dst = (i % 2 == 0) ? a : b;
+        ASSERT(skiplist_add(dst, (void *) i, (void *) (2 * i)));
+    }
+    /* A key present in both lists: both pairs survive the merge. */
+    ASSERT(skiplist_add(a, (void *) 11L, (void *) -1L));
+
+    ASSERT(skiplist_merge(a, b));
+    ASSERT_EQ_FMT((size_t)limit + 1, skiplist_count(a), "%zd");
+    ASSERT(skiplist_empty(b));
+    skiplist_debug(a, NULL, NULL, NULL);
+    skiplist_debug(b, NULL, NULL, NULL);
+    for (long i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(a, (void *) i, &v));
+        if (i != 11) { ASSERT_EQ(2 * i, (long) v); }
+    }
+
+    /* The source is empty but still usable. */
+    ASSERT(skiplist_add(b, (void *) 5L, (void *) 5L));
+    ASSERT_EQ_FMT((size_t)1, skiplist_count(b), "%zd");
+
+    skiplist_free(a, NULL, NULL);
+    skiplist_free(b, NULL, NULL);
+    PASS();
+}
+
+/* Splitting severs at the pivot in place: keys >= the pivot
+ * (including duplicates of it) move to the returned list. */
+TEST split_list(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 1000;
+    for (long i = 0; i < limit; i++) {
+        long k = (i * 7919) % limit;
+        ASSERT(skiplist_add(sl, (void *) k, (void *) k));
+    }
+    ASSERT(skiplist_add(sl, (void *) 700L, (void *) 700L));
+
+    struct skiplist *hi = skiplist_split(sl, (void *) 700L);
+    ASSERT(hi);
+    ASSERT_EQ_FMT((size_t)700, skiplist_count(sl), "%zd");
+    ASSERT_EQ_FMT((size_t)(limit - 700 + 1), skiplist_count(hi), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+    skiplist_debug(hi, NULL, NULL, NULL);
+    ASSERT_FALSE(skiplist_member(sl, (void *) 700L));
+    ASSERT(skiplist_member(hi, (void *) 700L));
+    ASSERT(skiplist_member(sl, (void *) 699L));
+    ASSERT(skiplist_member(hi, (void *) (limit - 1)));
+
+    /* Pivots beyond either end move everything, or nothing. */
+    struct skiplist *all = skiplist_split(hi, (void *) -1L);
+    ASSERT(all);
+    ASSERT(skiplist_empty(hi));
+    ASSERT_EQ_FMT((size_t)(limit - 700 + 1), skiplist_count(all), "%zd");
+    struct skiplist *none = skiplist_split(all, (void *) (2 * limit));
+    ASSERT(none);
+    ASSERT(skiplist_empty(none));
+    skiplist_debug(all, NULL, NULL, NULL);
+
+    /* The pieces remain fully functional, and merge back. */
+    ASSERT(skiplist_add(sl, (void *) 5000L, (void *) 1L));
+    ASSERT(skiplist_merge(sl, all));
+    ASSERT_EQ_FMT((size_t)limit + 2, skiplist_count(sl), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    skiplist_free(sl, NULL, NULL);
+    skiplist_free(hi, NULL, NULL);
+    skiplist_free(all, NULL, NULL);
+    skiplist_free(none, NULL, NULL);
+    PASS();
+}
+
+/* Batch add/get/delete: shuffled input, results reported in the
+ * caller's order, misses as NULLs, and duplicate batch entries
+ * deleting duplicate keys. */
+TEST batch_ops(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 512;
+    const long largeish_prime = 7919;
+    void **keys = test_malloc(limit * sizeof(void *));
+    void **vals = test_malloc(limit * sizeof(void *));
+    ASSERT(keys);
+    ASSERT(vals);
+
+    /* A shuffled batch of adds. */
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        keys[i] = (void *) k;
+        vals[i] = (void *) (2 * k);
+    }
+    ASSERT_EQ_FMT((size_t)limit,
+        skiplist_add_batch(sl, keys, vals, limit), "%zd");
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    /* Get them back in the caller's (shuffled) order, with some
+     * missing keys mixed in. */
+    long k7 = (7 * largeish_prime) % limit;
+    long k100 = (100 * largeish_prime) % limit;
+    keys[7] = (void *) (limit + 7);     /* not present */
+    keys[100] = (void *) -3L;           /* not present */
+    ASSERT_EQ_FMT((size_t)limit - 2,
+        skiplist_get_batch(sl, keys, vals, limit), "%zd");
+    for (long i = 0; i < limit; i++) {
+        if (i == 7 || i == 100) {
+            ASSERT_EQ(NULL, vals[i]);
+        } else {
+            ASSERT_EQ(2 * (long) keys[i], (long) vals[i]);
+        }
+    }
+
+    /* Delete a batch where key 5 appears twice: both duplicates of
+     * it go, the two keys no longer in the batch stay. */
+    ASSERT(skiplist_add(sl, (void *) 5L, (void *) 10L));
+    keys[7] = (void *) 5L;
+    ASSERT_EQ_FMT((size_t)limit - 1,
+        skiplist_delete_batch(sl, keys, vals, limit), "%zd");
+    ASSERT_EQ_FMT((size_t)2, skiplist_count(sl), "%zd");
+    ASSERT(skiplist_member(sl, (void *) k7));
+    ASSERT(skiplist_member(sl, (void *) k100));
+    ASSERT_FALSE(skiplist_member(sl, (void *) 5L));
+    ASSERT_EQ(NULL, vals[100]);
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    test_free(keys, limit * sizeof(void *));
+    test_free(vals, limit * sizeof(void *));
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Interleaved point lookups: unsorted probe keys, a mix of hits and
+ * misses, including batches smaller than the number of search lanes. */
+TEST get_many(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 1000;
+    const long largeish_prime = 7919;
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) (3 * i)));
+    }
+
+    const long batch = 257;     /* not a multiple of the lane count */
+    void **keys = test_malloc(batch * sizeof(void *));
+    void **vals = test_malloc(batch * sizeof(void *));
+    ASSERT(keys);
+    ASSERT(vals);
+
+    /* Every third probe misses. */
+    long misses = 0;
+    for (long i = 0; i < batch; i++) {
+        long k = (i * largeish_prime) % limit;
+        if (i % 3 == 0) {
+            k += limit;
+            misses++;
+        }
+        keys[i] = (void *) k;
+    }
+    ASSERT_EQ_FMT((size_t)(batch - misses),
+        skiplist_get_many(sl, keys, vals, batch), "%zd");
+    for (long i = 0; i < batch; i++) {
+        if (i % 3 == 0) {
+            ASSERT_EQ(NULL, vals[i]);
+        } else {
+            ASSERT_EQ(3 * (long) keys[i], (long) vals[i]);
+        }
+    }
+
+    /* Fewer probes than lanes. */
+    keys[0] = (void *) 23L;
+    keys[1] = (void *) -1L;
+    keys[2] = (void *) (limit - 1);
+    ASSERT_EQ_FMT((size_t)2, skiplist_get_many(sl, keys, vals, 3), "%zd");
+    ASSERT_EQ(3 * 23L, (long) vals[0]);
+    ASSERT_EQ(NULL, vals[1]);
+    ASSERT_EQ(3 * (limit - 1), (long) vals[2]);
+
+    ASSERT_EQ_FMT((size_t)0, skiplist_get_many(sl, keys, vals, 0), "%zd");
+
+    test_free(keys, batch * sizeof(void *));
+    test_free(vals, batch * sizeof(void *));
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+#if SKIPLIST_FINGERPRINT
+static size_t full_cmp_calls = 0;
+
+static int counting_strcmp(void *a, void *b) {
+    full_cmp_calls++;
+    return strcmp((char *) a, (char *) b);
+}
+
+/* The first 8 bytes of the string, packed big-endian: monotonic
+ * with strcmp, since shorter strings pad with zero bytes. */
+static uint64_t str_prefix8(void *key) {
+    const unsigned char *s = (const unsigned char *) key;
+    uint64_t fp = 0;
+    for (int i = 0; i < 8 && s[i]; i++) {
+        fp |= ((uint64_t) s[i]) << (56 - 8 * i);
+    }
+    return fp;
+}
+
+/* With a prefix callback set, searches behave identically but
+ * resolve most comparisons on the fingerprints alone. */
+TEST fingerprint_search(void) {
+    struct skiplist *sl = skiplist_new(counting_strcmp, test_alloc, NULL);
+    ASSERT(sl);
+    skiplist_set_prefix_cb(sl, str_prefix8);
+
+    size_t ct = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(sl, *w, *w));
+        ct++;
+    }
+    ASSERT_EQ_FMT(ct, skiplist_count(sl), "%zd");
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    full_cmp_calls = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(sl, *w, &v));
+        ASSERT_EQ(*w, (char *) v);
+    }
+    ASSERT_FALSE(skiplist_member(sl, "zzzz-not-a-word"));
+    size_t with_fp = full_cmp_calls;
+
+    /* The same lookups without a prefix callback should need far
+     * more full comparisons: one per node visited, rather than one
+     * or two per fingerprint tie. */
+    struct skiplist *plain = skiplist_new(counting_strcmp,
+        test_alloc, NULL);
+    ASSERT(plain);
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(plain, *w, *w));
+    }
+    full_cmp_calls = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_member(plain, *w));
+    }
+    ASSERT_FALSE(skiplist_member(plain, "zzzz-not-a-word"));
+    size_t without_fp = full_cmp_calls;
+    if (0) fprintf(stderr, "full cmps: %zd with fp, %zd without\n",
+        with_fp, without_fp);
+    ASSERT(with_fp < without_fp / 2);
+
+    /* Deletion searches take the fingerprint path too. */
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_delete(sl, *w, NULL));
+    }
+    ASSERT(skiplist_empty(sl));
+
+    skiplist_free(sl, NULL, NULL);
+    skiplist_free(plain, NULL, NULL);
+    PASS();
+}
+#endif
+
+#if SKIPLIST_STATS
+TEST stats_counters(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    skiplist_set_seed_local(sl, 23);
+    const long limit = 1000;
+
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_member(sl, (void *) i));
+    }
+
+    struct skiplist_stats st;
+    skiplist_stats(sl, &st);
+
+    /* The height histogram covers exactly the live nodes, and with
+     * the default geometric distribution over 1000 nodes the head
+     * must have grown past its initial single level. */
+    size_t nodes = 0;
+    for (int h = 0; h < SKIPLIST_MAX_HEIGHT; h++) {
+        nodes += st.nodes_at_height[h];
+    }
+    ASSERT_EQ_FMT(skiplist_count(sl), nodes, "%zd");
+    ASSERT(st.nodes_at_height[0] > st.nodes_at_height[4]);
+    ASSERT(st.head_grows > 0);
+
+    /* Every add and lookup above did one search; comparisons should
+     * average out near 2 * log2(count), so 100x that is generous. */
+    ASSERT(st.searches >= 2 * (uint64_t)limit);
+    ASSERT(st.comparisons >= st.searches);
+    ASSERT(st.comparisons < st.searches * 100);
+
+    /* Byte accounting shrinks when nodes are freed. */
+    for (long i = 0; i < limit / 2; i++) {
+        ASSERT(skiplist_delete(sl, (void *) i, NULL));
+    }
+    struct skiplist_stats st2;
+    skiplist_stats(sl, &st2);
+    ASSERT(st2.bytes < st.bytes);
+    ASSERT(st2.bytes > 0);
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* With the adaptive cap, a small list holds no nodes taller than
+ * log2(count) + 1; the cap rises as the list grows, so a large list
+ * still gets its tall express lanes. */
+TEST adaptive_height(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    skiplist_set_seed_local(sl, 17);
+    skiplist_set_adaptive_height(sl, true);
+
+    const long small = 100;     /* cap: floor(log2(99)) + 1 == 7 */
+    for (long i = 0; i < small; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+    struct skiplist_stats st;
+    skiplist_stats(sl, &st);
+    for (int h = 7; h < SKIPLIST_MAX_HEIGHT; h++) {
+        ASSERT_EQ_FMT((size_t)0, st.nodes_at_height[h], "%zd");
+    }
+
+    const long limit = 100000;
+    for (long i = small; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+    skiplist_debug(sl, NULL, NULL, NULL);
+    skiplist_stats(sl, &st);
+    size_t tall = 0;
+    for (int h = 7; h < SKIPLIST_MAX_HEIGHT; h++) {
+        tall += st.nodes_at_height[h];
+    }
+    ASSERT(tall > 0);
+
+    for (long i = 0; i < limit; i += 997) {
+        ASSERT(skiplist_member(sl, (void *) i));
+    }
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+#endif
+
+/* The fixed-size byte comparators order exactly like memcmp: check
+ * a difference at every byte position in both directions, that only
+ * the first differing byte decides, and that a skiplist keyed on
+ * 16-byte blobs through skiplist_cmp_bytes16 sorts them. */
+TEST cmp_bytes(void) {
+    uint8_t a[64], b[64];
+    memset(a, 0xab, sizeof(a));
+    memset(b, 0xab, sizeof(b));
+    ASSERT_EQ(0, skiplist_cmp_bytes16(a, b));
+    ASSERT_EQ(0, skiplist_cmp_bytes32(a, b));
+    ASSERT_EQ(0, skiplist_cmp_bytes64(a, b));
+
+    for (size_t at = 0; at < 64; at++) {
+        a[at] = 0x7f;           /* bytes compare unsigned: */
+        b[at] = 0x80;           /* 0x7f < 0x80 */
+        if (at < 16) {
+            ASSERT(skiplist_cmp_bytes16(a, b) < 0);
+            ASSERT(skiplist_cmp_bytes16(b, a) > 0);
+        }
+        if (at < 32) {
+            ASSERT(skiplist_cmp_bytes32(a, b) < 0);
+            ASSERT(skiplist_cmp_bytes32(b, a) > 0);
+        }
+        ASSERT(skiplist_cmp_bytes64(a, b) < 0);
+        ASSERT(skiplist_cmp_bytes64(b, a) > 0);
+        a[at] = b[at] = 0xab;
+    }
+
+    a[3] = 0x01; b[3] = 0x02;
+    a[10] = 0xff; b[10] = 0x00;
+    ASSERT(skiplist_cmp_bytes16(a, b) < 0);
+    a[3] = b[3] = 0xab;
+    ASSERT(skiplist_cmp_bytes16(a, b) > 0);
+    a[10] = b[10] = 0xab;
+
+    /* 16-byte big-endian counters sort numerically. */
+    const long limit = 500;
+    const long largeish_prime = 7919;
+    uint8_t (*keys)[16] = test_malloc(limit * 16);
+    ASSERT(keys);
+    memset(keys, 0, limit * 16);
+    struct skiplist *sl = skiplist_new(skiplist_cmp_bytes16,
+        test_alloc, NULL);
+    ASSERT(sl);
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        keys[k][14] = (uint8_t)(k >> 8);
+        keys[k][15] = (uint8_t)k;
+        ASSERT(skiplist_add(sl, keys[k], (void *) k));
+    }
+    skiplist_debug(sl, NULL, NULL, NULL);
+    for (long i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_get(sl, keys[i], &v));
+        ASSERT_EQ(i, (long) v);
+    }
+    void *first = NULL, *last = NULL;
+    ASSERT(skiplist_first(sl, &first, NULL));
+    ASSERT(skiplist_last(sl, &last, NULL));
+    ASSERT(first == (void *)keys[0]);
+    ASSERT(last == (void *)keys[limit - 1]);
+    skiplist_free(sl, NULL, NULL);
+    test_free(keys, limit * 16);
+    PASS();
+}
+
+/* Add/get/delete against the unrolled variant, inserting in a
+ * pseudo-random order so blocks split at scattered points. */
+TEST unrolled_add_get_delete(void) {
+    struct skiplist_u *sl = skiplist_u_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 1000;
+    const long largeish_prime = 7919;
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        ASSERT(skiplist_u_add(sl, (void *) k, (void *) (2 * k)));
+    }
+    ASSERT_EQ_FMT((size_t)limit, skiplist_u_count(sl), "%zd");
+
+    /* Re-adding a present key replaces its value, count unchanged. */
+    ASSERT(skiplist_u_add(sl, (void *) 500L, (void *) 999L));
+    ASSERT_EQ_FMT((size_t)limit, skiplist_u_count(sl), "%zd");
+    void *v = NULL;
+    ASSERT(skiplist_u_get(sl, (void *) 500L, &v));
+    ASSERT_EQ(999L, (long) v);
+    ASSERT(skiplist_u_add(sl, (void *) 500L, (void *) 1000L));
+
+    for (long i = 0; i < limit; i++) {
+        v = NULL;
+        ASSERT(skiplist_u_get(sl, (void *) i, &v));
+        ASSERT_EQ(2 * i, (long) v);
+        ASSERT(skiplist_u_member(sl, (void *) i));
+    }
+    ASSERT_FALSE(skiplist_u_member(sl, (void *) limit));
+    ASSERT_FALSE(skiplist_u_member(sl, (void *) -1L));
+
+    /* Delete the odd keys (in a scattered order, again), then
+     * confirm exactly the even ones remain. */
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        if (k % 2 == 0) { continue; }
+        v = NULL;
+        ASSERT(skiplist_u_delete(sl, (void *) k, &v));
+        ASSERT_EQ(2 * k, (long) v);
+        ASSERT_FALSE(skiplist_u_delete(sl, (void *) k, NULL));
+    }
+    ASSERT_EQ_FMT((size_t)limit / 2, skiplist_u_count(sl), "%zd");
+    for (long i = 0; i < limit; i++) {
+        ASSERT_EQ(i % 2 == 0, skiplist_u_member(sl, (void *) i));
+    }
+
+    /* Drain it completely; every block should be unlinked. */
+    for (long i = 0; i < limit; i += 2) {
+        ASSERT(skiplist_u_delete(sl, (void *) i, NULL));
+    }
+    ASSERT(skiplist_u_empty(sl));
+    ASSERT_EQ_FMT((size_t)0, skiplist_u_free(sl, NULL, NULL), "%zd");
+    PASS();
+}
+
+struct unrolled_iter_env {
+    size_t ct;
+    long prev;
+    bool have_prev;
+    size_t stop_after;
+};
+
+static enum skiplist_iter_res
+unrolled_iter_cb(void *k, void *v, void *udata) {
+    struct unrolled_iter_env *env = (struct unrolled_iter_env *) udata;
+    long key = (long) k;
+    if (env->have_prev && key <= env->prev) { return SKIPLIST_ITER_HALT; }
+    if ((long) v != 2 * key) { return SKIPLIST_ITER_HALT; }
+    env->prev = key;
+    env->have_prev = true;
+    env->ct++;
+    if (env->stop_after && env->ct == env->stop_after) {
+        return SKIPLIST_ITER_HALT;
+    }
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+/* Iteration over the unrolled variant visits every pair in ascending
+ * key order, within and across blocks. */
+TEST unrolled_iter(void) {
+    struct skiplist_u *sl = skiplist_u_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 500;
+    const long largeish_prime = 7919;
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        ASSERT(skiplist_u_add(sl, (void *) (2 * k), (void *) (4 * k)));
+    }
+
+    struct unrolled_iter_env env = { .ct = 0 };
+    skiplist_u_iter(sl, unrolled_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)limit, env.ct, "%zd");
+    ASSERT_EQ(2 * (limit - 1), env.prev);
+
+    /* From a present key, and from a key between two pairs. */
+    env = (struct unrolled_iter_env) { .ct = 0 };
+    skiplist_u_iter_from(sl, (void *) 100L, unrolled_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)(limit - 50), env.ct, "%zd");
+
+    env = (struct unrolled_iter_env) { .ct = 0 };
+    skiplist_u_iter_from(sl, (void *) 101L, unrolled_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)(limit - 51), env.ct, "%zd");
+
+    /* Early termination stops the walk mid-block. */
+    env = (struct unrolled_iter_env) { .ct = 0, .stop_after = 3 };
+    skiplist_u_iter(sl, unrolled_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)3, env.ct, "%zd");
+
+    ASSERT_EQ_FMT((size_t)limit, skiplist_u_free(sl, NULL, NULL), "%zd");
+    PASS();
+}
+
+struct cow_iter_env {
+    size_t ct;
+    long sum;
+    long prev;
+};
+
+static enum skiplist_iter_res cow_iter_cb(void *key, void *value,
+        void *udata) {
+    struct cow_iter_env *env = (struct cow_iter_env *)udata;
+    if (env->ct > 0) { assert((long) key > env->prev); }
+    env->prev = (long) key;
+    env->ct++;
+    env->sum += (long) value;
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+static size_t cow_drops = 0;
+
+static void cow_drop_cb(void *key, void *value, void *udata) {
+    (void)key;
+    (void)value;
+    (void)udata;
+    cow_drops++;
+}
+
+/* Snapshots keep a frozen view while the live view keeps changing,
+ * and every replaced/deleted/shadowed pair reaches the drop callback
+ * exactly once. */
+TEST cow_snapshot(void) {
+    struct skiplist_cow *cow = skiplist_cow_new(sl_longcmp,
+        test_alloc, NULL);
+    ASSERT(cow);
+    cow_drops = 0;
+    skiplist_cow_set_drop_cb(cow, cow_drop_cb, NULL);
+    const long limit = 500;
+    for (long i = 0; i < limit; i++) {
+        ASSERT(skiplist_cow_add(cow, (void *) i, (void *) (i + 1)));
+    }
+
+    struct skiplist_cow_snap *snap = skiplist_cow_snapshot(cow);
+    ASSERT(snap);
+
+    /* Mutate the live view: delete the front half, overwrite some
+     * values, add new keys past the end. */
+    for (long i = 0; i < limit / 2; i++) {
+        ASSERT(skiplist_cow_delete(cow, (void *) i));
+    }
+    for (long i = limit / 2; i < limit; i++) {
+        ASSERT(skiplist_cow_add(cow, (void *) i, (void *) (i + 1000)));
+    }
+    for (long i = limit; i < limit + 100; i++) {
+        ASSERT(skiplist_cow_add(cow, (void *) i, (void *) (i + 1000)));
+    }
+
+    /* The live view reflects all of it... */
+    void *v = NULL;
+    ASSERT_FALSE(skiplist_cow_member(cow, (void *) 0L));
+    ASSERT(skiplist_cow_get(cow, (void *) (limit / 2), &v));
+    ASSERT_EQ(limit / 2 + 1000, (long) v);
+    ASSERT(skiplist_cow_get(cow, (void *) limit, &v));
+    ASSERT_EQ(limit + 1000, (long) v);
+
+    /* ...while the snapshot still sees the point-in-time state. */
+    ASSERT(skiplist_cow_snap_get(snap, (void *) 0L, &v));
+    ASSERT_EQ(1L, (long) v);
+    ASSERT(skiplist_cow_snap_get(snap, (void *) (limit / 2), &v));
+    ASSERT_EQ(limit / 2 + 1, (long) v);
+    ASSERT_FALSE(skiplist_cow_snap_get(snap, (void *) limit, &v));
+
+    struct cow_iter_env env = { .ct = 0 };
+    skiplist_cow_snap_iter(snap, cow_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)limit, env.ct, "%zd");
+    ASSERT_EQ_FMT(limit * (limit + 1) / 2, env.sum, "%ld");
+
+    /* Nothing has been dropped yet: the snapshot pins every old
+     * pair. Releasing it squashes the layers and drops the halves
+     * that were deleted or overwritten. */
+    ASSERT_EQ_FMT((size_t)0, cow_drops, "%zd");
+    skiplist_cow_snap_release(snap);
+    ASSERT_EQ_FMT((size_t)limit, cow_drops, "%zd");
+
+    /* A second snapshot over the squashed state. */
+    snap = skiplist_cow_snapshot(cow);
+    ASSERT(snap);
+    env = (struct cow_iter_env) { .ct = 0 };
+    skiplist_cow_snap_iter(snap, cow_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)(limit / 2 + 100), env.ct, "%zd");
+    skiplist_cow_snap_release(snap);
+
+    ASSERT_EQ_FMT((size_t)(limit / 2 + 100),
+        skiplist_cow_free(cow, NULL, NULL), "%zd");
+    PASS();
+}
+
+/* Two overlapping snapshots see their own generations. */
+TEST cow_snapshot_overlap(void) {
+    struct skiplist_cow *cow = skiplist_cow_new(sl_longcmp,
+        test_alloc, NULL);
+    ASSERT(cow);
+    for (long i = 0; i < 100; i++) {
+        ASSERT(skiplist_cow_add(cow, (void *) i, (void *) i));
+    }
+    struct skiplist_cow_snap *s1 = skiplist_cow_snapshot(cow);
+    ASSERT(s1);
+    ASSERT(skiplist_cow_delete(cow, (void *) 50L));
+    struct skiplist_cow_snap *s2 = skiplist_cow_snapshot(cow);
+    ASSERT(s2);
+    ASSERT(skiplist_cow_add(cow, (void *) 50L, (void *) 999L));
+
+    void *v = NULL;
+    ASSERT(skiplist_cow_snap_get(s1, (void *) 50L, &v));
+    ASSERT_EQ(50L, (long) v);
+    ASSERT_FALSE(skiplist_cow_snap_get(s2, (void *) 50L, &v));
+    ASSERT(skiplist_cow_get(cow, (void *) 50L, &v));
+    ASSERT_EQ(999L, (long) v);
+
+    /* Release out of order. */
+    skiplist_cow_snap_release(s1);
+    ASSERT_FALSE(skiplist_cow_snap_get(s2, (void *) 50L, &v));
+    struct cow_iter_env env = { .ct = 0 };
+    skiplist_cow_snap_iter(s2, cow_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)99, env.ct, "%zd");
+    skiplist_cow_snap_release(s2);
+
+    ASSERT_EQ_FMT((size_t)100, skiplist_cow_free(cow, NULL, NULL), "%zd");
+    PASS();
+}
+
+static bool compact_encode_cb(void *key, void *value,
+        const void **key_buf, size_t *key_len,
+        const void **val_buf, size_t *val_len, void *udata) {
+    (void)udata;
+    *key_buf = key;
+    *key_len = strlen((char *) key);
+    *val_buf = value;
+    *val_len = strlen((char *) value);
+    return true;
+}
+
+struct mapped_iter_env {
+    size_t ct;
+    const char *prev;
+    size_t prev_len;
+};
+
+static enum skiplist_iter_res mapped_iter_cb(const void *key,
+        size_t key_len, const void *value, size_t value_len,
+        void *udata) {
+    struct mapped_iter_env *env = (struct mapped_iter_env *)udata;
+    assert(key_len == value_len);
+    assert(0 == memcmp(key, value, key_len));
+    if (env->prev) {
+        size_t min = env->prev_len < key_len ? env->prev_len : key_len;
+        assert(memcmp(env->prev, key, min) <= 0);
+    }
+    env->prev = (const char *) key;
+    env->prev_len = key_len;
+    env->ct++;
+    return SKIPLIST_ITER_CONTINUE;
+}
+
+/* Compact a list to a flat file, then serve reads from an mmap of
+ * it: point lookups, positional access, and ordered iteration. */
+TEST compact_and_map(void) {
+    const char *path = "test_compact.slcf";
+    struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
+    ASSERT(sl);
+    size_t ct = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(sl, *w, *w));
+        ct++;
+    }
+    ASSERT(skiplist_compact_to_file(sl, path, compact_encode_cb, NULL));
+    skiplist_free(sl, NULL, NULL);
+
+    struct skiplist_m *m = skiplist_m_open(path, NULL);
+    ASSERT(m);
+    ASSERT_EQ_FMT(ct, skiplist_m_count(m), "%zd");
+
+    for (char **w = (char **)wordlist; *w; w++) {
+        const void *v = NULL;
+        size_t vlen = 0;
+        ASSERT(skiplist_m_get(m, *w, strlen(*w), &v, &vlen));
+        ASSERT_EQ_FMT(strlen(*w), vlen, "%zd");
+        ASSERT(0 == memcmp(*w, v, vlen));
+    }
+    ASSERT_FALSE(skiplist_m_member(m, "zzzz-not-a-word", 15));
+
+    /* Positional access covers the whole file in key order. */
+    const void *prev = NULL;
+    size_t prev_len = 0;
+    for (size_t i = 0; i < ct; i++) {
+        const void *k = NULL;
+        size_t klen = 0;
+        ASSERT(skiplist_m_at_index(m, i, &k, &klen, NULL, NULL));
+        if (prev) {
+            size_t min = prev_len < klen ? prev_len : klen;
+            ASSERT(memcmp(prev, k, min) <= 0);
+        }
+        prev = k;
+        prev_len = klen;
+    }
+    ASSERT_FALSE(skiplist_m_at_index(m, ct, NULL, NULL, NULL, NULL));
+
+    struct mapped_iter_env env = { .ct = 0 };
+    skiplist_m_iter(m, mapped_iter_cb, &env);
+    ASSERT_EQ_FMT(ct, env.ct, "%zd");
+
+    /* iter_from picks up at the first key >= the probe. */
+    env = (struct mapped_iter_env) { .ct = 0 };
+    skiplist_m_iter_from(m, "n", 1, mapped_iter_cb, &env);
+    ASSERT(env.ct > 0);
+    ASSERT(env.ct < ct);
+
+    skiplist_m_close(m);
+
+    /* Corrupt the first index entry (the uint64 at index_off, which
+     * the header stores at byte 16): open must reject the file
+     * rather than fault on the out-of-range record offset. */
+    FILE *f = fopen(path, "r+b");
+    ASSERT(f);
+    uint64_t index_off = 0;
+    ASSERT(0 == fseek(f, 16, SEEK_SET));
+    ASSERT(1 == fread(&index_off, sizeof(index_off), 1, f));
+    uint64_t bogus = ~(uint64_t)0;
+    ASSERT(0 == fseek(f, (long)index_off, SEEK_SET));
+    ASSERT(1 == fwrite(&bogus, sizeof(bogus), 1, f));
+    ASSERT(0 == fclose(f));
+    ASSERT_FALSE(skiplist_m_open(path, NULL));
+
+    remove(path);
+    PASS();
+}
+
+struct sharded_iter_env {
+    size_t ct;
+    long prev;
+    bool have_prev;
+    size_t stop_after;
+    bool ok;
+};
+
+static enum skiplist_iter_res sharded_iter_cb(void *k, void *v,
+        void *udata) {
+    struct sharded_iter_env *env = (struct sharded_iter_env *) udata;
+    long key = (long) k;
+    if (env->have_prev && key <= env->prev) { env->ok = false; }
+    if ((long) v != 2 * key) { env->ok = false; }
+    env->prev = key;
+    env->have_prev = true;
+    env->ct++;
+    return (env->stop_after && env->ct == env->stop_after)
+        ? SKIPLIST_ITER_HALT : SKIPLIST_ITER_CONTINUE;
+}
+
+/* Routing, counting, iteration, and fanned-out range queries across
+ * a 4-shard container. The default allocator is used here: range
+ * extraction allocates from several worker threads at once, which
+ * the test allocator's global byte counter can't track safely. */
+TEST sharded_ops(void) {
+    void *splits[3] = { (void *) 250L, (void *) 500L, (void *) 750L };
+    struct skiplist_sharded *ssl = skiplist_sharded_new(sl_longcmp,
+        NULL, NULL, 4, splits);
+    ASSERT(ssl);
+
+    const long limit = 1000;
+    const long largeish_prime = 7919;
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        ASSERT(skiplist_sharded_add(ssl, (void *) k, (void *) (2 * k)));
+    }
+    ASSERT_EQ_FMT((size_t)limit, skiplist_sharded_count(ssl), "%zd");
+
+    void *v = NULL;
+    ASSERT(skiplist_sharded_get(ssl, (void *) 600L, &v));
+    ASSERT_EQ(1200L, (long) v);
+    ASSERT(skiplist_sharded_member(ssl, (void *) 250L)); /* on a split */
+    ASSERT_FALSE(skiplist_sharded_member(ssl, (void *) limit));
+
+    void *old = NULL;
+    ASSERT(skiplist_sharded_set(ssl, (void *) 600L, (void *) 999L, &old));
+    ASSERT_EQ(1200L, (long) old);
+    ASSERT_EQ_FMT((size_t)limit, skiplist_sharded_count(ssl), "%zd");
+    ASSERT(skiplist_sharded_delete(ssl, (void *) 600L, &v));
+    ASSERT_EQ(999L, (long) v);
+    ASSERT_FALSE(skiplist_sharded_member(ssl, (void *) 600L));
+    ASSERT(skiplist_sharded_add(ssl, (void *) 600L, (void *) 1200L));
+
+    /* Iteration crosses the shard boundaries in ascending order. */
+    struct sharded_iter_env env = { .ok = true };
+    skiplist_sharded_iter(ssl, sharded_iter_cb, &env);
+    ASSERT(env.ok);
+    ASSERT_EQ_FMT((size_t)limit, env.ct, "%zd");
+    ASSERT_EQ(limit - 1, env.prev);
+
+    env = (struct sharded_iter_env) { .ok = true };
+    skiplist_sharded_iter_from(ssl, (void *) 400L,
+        sharded_iter_cb, &env);
+    ASSERT(env.ok);
+    ASSERT_EQ_FMT((size_t)(limit - 400), env.ct, "%zd");
+
+    env = (struct sharded_iter_env) { .ok = true, .stop_after = 5 };
+    skiplist_sharded_iter(ssl, sharded_iter_cb, &env);
+    ASSERT_EQ_FMT((size_t)5, env.ct, "%zd");
+
+    /* A range spanning all four shards comes back in one ascending
+     * stream; one inside a single shard skips the fan-out. */
+    env = (struct sharded_iter_env) { .ok = true };
+    ASSERT_EQ_FMT((size_t)801,
+        skiplist_sharded_range(ssl, (void *) 100L, (void *) 900L,
+            sharded_iter_cb, &env), "%zd");
+    ASSERT(env.ok);
+    ASSERT_EQ(900L, env.prev);
+
+    env = (struct sharded_iter_env) { .ok = true };
+    ASSERT_EQ_FMT((size_t)11,
+        skiplist_sharded_range(ssl, (void *) 300L, (void *) 310L,
+            sharded_iter_cb, &env), "%zd");
+    ASSERT(env.ok);
+
+    /* A halting callback stops the delivery. */
+    env = (struct sharded_iter_env) { .ok = true, .stop_after = 7 };
+    ASSERT_EQ_FMT((size_t)7,
+        skiplist_sharded_range(ssl, (void *) 0L, (void *) 999L,
+            sharded_iter_cb, &env), "%zd");
+
+    ASSERT_EQ_FMT((size_t)limit,
+        skiplist_sharded_free(ssl, NULL, NULL), "%zd");
+    PASS();
+}
+
+TEST cursor_walk(void) {
+    struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
+    ASSERT(sl);
+    size_t ct = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(sl, *w, *w));
+        ct++;
+    }
+
+    struct skiplist_cursor *c = skiplist_cursor_open(sl);
+    ASSERT(c);
+    size_t seen = 0;
+    char *prev = NULL;
+    char *k = NULL;
+    while (skiplist_cursor_get(c, (void **) &k, NULL)) {
+        if (prev) { ASSERT(strcmp(prev, k) <= 0); }
+        prev = k;
+        seen++;
+        skiplist_cursor_next(c);
+    }
+    ASSERT_EQ_FMT(ct, seen, "%zd");
+
+    /* Walk all the way back with prev: once to the last pair,
+     * then ct - 1 steps back to the first. */
+    while (skiplist_cursor_prev(c)) { seen--; }
+    ASSERT_EQ_FMT((size_t)0, seen, "%zd");
+    k = NULL;
+    ASSERT(skiplist_cursor_get(c, (void **) &k, NULL));
+    char *first_k = NULL;
+    ASSERT(skiplist_first(sl, (void **) &first_k, NULL));
+    ASSERT(0 == strcmp(k, first_k));
+
+    skiplist_cursor_close(c);
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Seek a cursor and interleave a second cursor over the same
+ * skiplist, as a merge join would. */
+TEST cursor_seek_and_interleave(void) {
+    struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
+    ASSERT(sl);
+    size_t ct = 0;
+    for (char **w = (char **)wordlist; *w; w++) {
+        ASSERT(skiplist_add(sl, *w, *w));
+        ct++;
+    }
+
+    struct skiplist_cursor *c = skiplist_cursor_open(sl);
+    ASSERT(c);
+    ASSERT(skiplist_cursor_seek(c, "onion"));
+    char *k = NULL;
+    ASSERT(skiplist_cursor_get(c, (void **) &k, NULL));
+    ASSERT(0 == strcmp(k, "onion"));
+
+    /* Count the pairs from the first "onion" on; should match
+     * the skiplist_iter_from count checked elsewhere. */
+    size_t seen = 0;
+    do { seen++; } while (skiplist_cursor_next(c));
+    ASSERT_EQ_FMT((size_t)62, seen, "%zd");
+
+    /* Seeking past the end leaves the cursor off the end. */
+    ASSERT(!skiplist_cursor_seek(c, "zzzzzz"));
+    ASSERT(!skiplist_cursor_get(c, NULL, NULL));
+
+    /* Two interleaved cursors don't disturb each other. */
+    struct skiplist_cursor *ca = skiplist_cursor_open(sl);
+    struct skiplist_cursor *cb = skiplist_cursor_open(sl);
+    ASSERT(ca);
+    ASSERT(cb);
+    size_t seen_a = 0, seen_b = 0;
+    while (skiplist_cursor_get(ca, NULL, NULL)) {
+        seen_a++;
+        skiplist_cursor_next(ca);
+        if (skiplist_cursor_get(cb, NULL, NULL)) {
+            seen_b++;
+            skiplist_cursor_next(cb);
+        }
+    }
+    ASSERT_EQ_FMT(ct, seen_a, "%zd");
+    ASSERT_EQ_FMT(ct, seen_b, "%zd");
+
+    skiplist_cursor_close(ca);
+    skiplist_cursor_close(cb);
+    skiplist_cursor_close(c);
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+#if SKIPLIST_BACK_POINTERS
+struct rev_env {
+    long prev;                  /* last key seen; starts above them all */
+    size_t seen;
+    size_t stop_after;          /* halt after this many pairs; 0: never */
+    bool ok;
+};
+
+static enum skiplist_iter_res rev_iter_cb(void *key, void *value,
+        void *udata) {
+    struct rev_env *env = (struct rev_env *)udata;
+    (void)value;
+    if (env->prev <= (long)key) { env->ok = false; }
+    env->prev = (long)key;
+    env->seen++;
+    return (env->stop_after && env->seen == env->stop_after)
+        ? SKIPLIST_ITER_HALT : SKIPLIST_ITER_CONTINUE;
+}
+
+/* Reverse iteration yields the pairs in descending key order, and
+ * the back-pointers stay consistent through deletes at both ends
+ * and in the middle (skiplist_debug checks every one). */
+TEST reverse_iter(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 1000;
+    const long largeish_prime = 7919;
+    for (long i = 0; i < limit; i++) {
+        long k = (i * largeish_prime) % limit;
+        ASSERT(skiplist_add(sl, (void *) (2 * k), (void *) k));
+    }
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    struct rev_env env = { .prev = 2 * limit, .ok = true };
+    skiplist_iter_reverse(sl, rev_iter_cb, &env);
+    ASSERT(env.ok);
+    ASSERT_EQ_FMT((size_t)limit, env.seen, "%zd");
+    ASSERT_EQ(0L, env.prev);    /* walked down to the first key */
+
+    /* Halting early yields just the last N pairs. */
+    env = (struct rev_env) { .prev = 2 * limit, .stop_after = 10,
+                             .ok = true };
+    skiplist_iter_reverse(sl, rev_iter_cb, &env);
+    ASSERT(env.ok);
+    ASSERT_EQ_FMT((size_t)10, env.seen, "%zd");
+    ASSERT_EQ(2 * (limit - 10), env.prev);
+
+    ASSERT(skiplist_delete(sl, (void *) 500L, NULL));
+    ASSERT(skiplist_pop_first(sl, NULL, NULL));
+    ASSERT(skiplist_pop_last(sl, NULL, NULL));
+    ASSERT_EQ(10, (long)skiplist_delete_range(sl,
+            (void *) 100L, (void *) 119L, NULL, NULL));
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    env = (struct rev_env) { .prev = 2 * limit, .ok = true };
+    skiplist_iter_reverse(sl, rev_iter_cb, &env);
+    ASSERT(env.ok);
+    ASSERT_EQ_FMT((size_t)(limit - 13), env.seen, "%zd");
+    ASSERT_EQ(2L, env.prev);
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+#endif
+
+/* Run an insert/delete churn workload against a pooled allocator:
+ * every node allocation after the first cycle should be recycled
+ * from the pool's free lists. */
+TEST pool_churn(void) {
+    struct skiplist_pool *p = skiplist_pool_new(0, 0);
+    ASSERT(p);
+    struct skiplist *sl = skiplist_new(sl_longcmp, skiplist_pool_cb, p);
+    ASSERT(sl);
+
+    const intptr_t limit = 1000;
+    for (int cycle = 0; cycle < 10; cycle++) {
+        for (intptr_t i = 0; i < limit; i++) {
+            ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+        }
+        ASSERT(skiplist_count(sl) == (size_t)limit);
+        for (intptr_t i = 0; i < limit; i++) {
+            void *v = NULL;
+            ASSERT(skiplist_delete(sl, (void *) i, &v));
+            ASSERT(v == (void *) i);
+        }
+        ASSERT(skiplist_empty(sl));
+    }
+
+    skiplist_free(sl, NULL, NULL);
+    skiplist_pool_free(p);
+    PASS();
+}
+
+/* A tiny slab size forces the pool to chain many slabs. */
+TEST pool_many_slabs(void) {
+    struct skiplist_pool *p = skiplist_pool_new(0, 256);
+    ASSERT(p);
+    struct skiplist *sl = skiplist_new(sl_longcmp, skiplist_pool_cb, p);
+    ASSERT(sl);
+
+    const intptr_t limit = 10000;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_member(sl, (void *) i));
+    }
+
+    skiplist_free(sl, NULL, NULL);
+    skiplist_pool_free(p);
+    PASS();
+}
+
+/* Exercise epoch-based reclamation: once a reader has entered an
+ * epoch, deleted nodes stay in limbo until skiplist_reclaim decides
+ * no reader from an old enough epoch can still reach them. */
+TEST epoch_reclaim(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const intptr_t limit = 100;
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_add(sl, (void *) i, (void *) i));
+    }
+
+    unsigned e = skiplist_epoch_enter(sl);
+
+    /* Deletes unlink immediately, but defer the frees. */
+    for (intptr_t i = 0; i < 5; i++) {
+        ASSERT(skiplist_delete(sl, (void *) i, NULL));
+        ASSERT(!skiplist_member(sl, (void *) i));
+    }
+    ASSERT(skiplist_count(sl) == (size_t)limit - 5);
+
+    /* First reclaim only flips the epoch (nothing old enough yet),
+     * and the next can't free while our reader is still in. */
+    ASSERT_EQ_FMT((size_t)0, skiplist_reclaim(sl), "%zd");
+    ASSERT_EQ_FMT((size_t)0, skiplist_reclaim(sl), "%zd");
+
+    skiplist_epoch_leave(sl, e);
+    ASSERT_EQ_FMT((size_t)5, skiplist_reclaim(sl), "%zd");
+    ASSERT_EQ_FMT((size_t)0, skiplist_reclaim(sl), "%zd");
+
+    /* Anything still in limbo is drained by skiplist_free; the
+     * teardown leak check verifies nothing is lost. */
+    e = skiplist_epoch_enter(sl);
+    ASSERT(skiplist_delete(sl, (void *) (intptr_t) 50, NULL));
+    skiplist_epoch_leave(sl, e);
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
+/* Single-threaded sanity check of the lock-free variant: the CAS
+ * paths are the same ones concurrent threads take, minus contention. */
+TEST concurrent_basic(void) {
+    struct skiplist *sl = skiplist_new_concurrent(sl_longcmp,
+        test_alloc, NULL);
+    ASSERT(sl);
+    const intptr_t limit = 200;
+
+    unsigned e = skiplist_epoch_enter(sl);
+    for (intptr_t i = 0; i < limit; i++) {
+        ASSERT(skiplist_concurrent_add(sl, (void *) i, (void *) (i * 2)));
+    }
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl), "%zd");
+
+    /* Duplicate keys are rejected. */
+    ASSERT(!skiplist_concurrent_add(sl, (void *) (intptr_t) 7, NULL));
+    ASSERT_EQ_FMT((size_t)limit, skiplist_count(sl), "%zd");
+
+    for (intptr_t i = 0; i < limit; i++) {
+        void *v = NULL;
+        ASSERT(skiplist_concurrent_member(sl, (void *) i));
+        ASSERT(skiplist_concurrent_get(sl, (void *) i, &v));
+        ASSERT_EQ(i * 2, (intptr_t) v);
+    }
+    ASSERT(!skiplist_concurrent_member(sl, (void *) limit));
+
+    /* Delete the odd keys; freed nodes sit in limbo until reclaimed. */
+    for (intptr_t i = 1; i < limit; i += 2) {
+        void *v = NULL;
+        ASSERT(skiplist_concurrent_delete(sl, (void *) i, &v));
+        ASSERT_EQ(i * 2, (intptr_t) v);
+        ASSERT(!skiplist_concurrent_member(sl, (void *) i));
+        ASSERT(!skiplist_concurrent_delete(sl, (void *) i, NULL));
+    }
+    ASSERT_EQ_FMT((size_t)limit / 2, skiplist_count(sl), "%zd");
+    for (intptr_t i = 0; i < limit; i += 2) {
+        ASSERT(skiplist_concurrent_member(sl, (void *) i));
+    }
+
+    /* Deleted keys can be re-added. */
+    ASSERT(skiplist_concurrent_add(sl, (void *) (intptr_t) 1, NULL));
+    ASSERT(skiplist_concurrent_member(sl, (void *) (intptr_t) 1));
+
+    skiplist_epoch_leave(sl, e);
+    ASSERT_EQ_FMT((size_t)0, skiplist_reclaim(sl), "%zd");
+    ASSERT_EQ_FMT((size_t)limit / 2, skiplist_reclaim(sl), "%zd");
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
 /* Get the first value. */
 TEST first(void) {
     struct skiplist *sl = skiplist_new(sl_strcmp, test_alloc, NULL);
@@ -685,6 +2405,109 @@ TEST free_clear(void) {
     PASS();
 }
 
+/* A registered destructor stands in for the free callback across
+ * the destructive operations, without threading cb/udata through
+ * every call. */
+TEST destructor(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    struct clear_cb_ud ud;
+    ud.count = 0;
+    ud.ok = 1;
+    skiplist_set_destructor(sl, clear_cb, &ud);
+
+    const long limit = 1000;
+    for (long i = 0; i < limit; i++) {
+        char buf[20];
+        snprintf(buf, 20, "%ld", i);
+        char *cp_buf = test_malloc(20);
+        ASSERT(cp_buf);
+        strncpy(cp_buf, buf, 20);
+        ASSERT(skiplist_add(sl, (void *) i, cp_buf));
+    }
+
+    /* delete_all and delete_range with a NULL callback destroy
+     * their pairs via the destructor... */
+    char *dup = test_malloc(20);
+    ASSERT(dup);
+    strncpy(dup, "5", 20);
+    ASSERT(skiplist_add(sl, (void *) 5L, dup));
+    skiplist_delete_all(sl, (void *) 5L, NULL, NULL);
+    ASSERT_FALSE(skiplist_member(sl, (void *) 5L));
+    ASSERT_EQ_FMT(2, ud.count, "%d");
+
+    ASSERT_EQ_FMT((size_t)10,
+        skiplist_delete_range(sl, (void *) 10L, (void *) 19L,
+            NULL, NULL), "%zd");
+    ASSERT_EQ_FMT(12, ud.count, "%d");
+
+    /* ...skiplist_delete hands the pair back instead... */
+    char *v = NULL;
+    ASSERT(skiplist_delete(sl, (void *) 23L, (void **) &v));
+    ASSERT(0 == strcmp("23", v));
+    test_free(v, 20);
+    ASSERT_EQ_FMT(12, ud.count, "%d");
+
+    /* ...an explicit callback still wins over the destructor... */
+    struct clear_cb_ud ud2;
+    ud2.count = 0;
+    ud2.ok = 1;
+    ASSERT_EQ_FMT((size_t)10,
+        skiplist_delete_range(sl, (void *) 30L, (void *) 39L,
+            clear_cb, &ud2), "%zd");
+    ASSERT_EQ_FMT(10, ud2.count, "%d");
+    ASSERT_EQ_FMT(12, ud.count, "%d");
+
+    /* ...and teardown picks it up too. */
+    int remaining = ud.count + (int) skiplist_count(sl);
+    ASSERT_EQ_FMT((size_t)(limit - 22), skiplist_free(sl, NULL, NULL),
+        "%zd");
+    ASSERT_EQ_FMT(remaining, ud.count, "%d");
+    ASSERT(ud.ok == 1);
+    PASS();
+}
+
+/* Detach every pair at once, then drain them in small chunks while
+ * the (now empty) skiplist is immediately reusable. */
+TEST detach_and_drain(void) {
+    struct skiplist *sl = skiplist_new(sl_longcmp, test_alloc, NULL);
+    ASSERT(sl);
+    const long limit = 10000;
+    for (long i = 0; i < limit; i++) {
+        char buf[20];
+        snprintf(buf, 20, "%ld", i);
+        char *cp_buf = test_malloc(20);
+        ASSERT(cp_buf);
+        strncpy(cp_buf, buf, 20);
+        ASSERT(skiplist_add(sl, (void *) i, cp_buf));
+    }
+
+    struct skiplist_detached *d = skiplist_detach(sl);
+    ASSERT(d);
+    ASSERT(skiplist_empty(sl));
+    skiplist_debug(sl, NULL, NULL, NULL);
+
+    /* The detached pairs are gone from the list, which can be
+     * repopulated before the old nodes have been drained. */
+    ASSERT(skiplist_add(sl, (void *) 23L, NULL));
+    ASSERT_EQ_FMT((size_t)1, skiplist_count(sl), "%zd");
+
+    struct clear_cb_ud ud;
+    ud.count = 0;
+    ud.ok = 1;
+    size_t total = 0, chunk = 0;
+    while ((chunk = skiplist_detach_drain(d, 256, clear_cb, &ud)) == 256) {
+        total += chunk;
+    }
+    total += chunk;             /* final short chunk freed the handle */
+    ASSERT(ud.ok == 1);
+    ASSERT_EQ_FMT((long)ud.count, limit, "%ld");
+    ASSERT_EQ_FMT((size_t)limit, total, "%zd");
+
+    skiplist_free(sl, NULL, NULL);
+    PASS();
+}
+
 /* Add numeric pairs, then pepeatedly pop the first key/value pair
  * until empty, and check invariants. */
 TEST pop_first(void) {
@@ -780,6 +2603,7 @@ SUITE(suite) {
     RUN_TEST(add_and_member);
     RUN_TEST(add_and_set);
     RUN_TEST(set);
+    RUN_TEST(update_in_place);
     RUN_TEST(trivial_delete);
     RUN_TEST(trivial_delete_not_present);
     RUN_TEST(delete_many_individually);
@@ -787,10 +2611,50 @@ SUITE(suite) {
     RUN_TEST(delete_all_first);
     RUN_TEST(delete_all_middle);
     RUN_TEST(delete_all_end);
+    RUN_TEST(delete_range);
+    RUN_TEST(at_index);
+    RUN_TEST(count_range);
+    RUN_TEST(load_sorted);
+    RUN_TEST(load_sorted_rejects_unsorted);
+    RUN_TEST(serialize_round_trip);
+    RUN_TEST(deserialize_rejects_garbage);
+    RUN_TEST(finger_ops);
+    RUN_TEST(batch_ops);
+    RUN_TEST(get_many);
+    RUN_TEST(seed_local_deterministic);
+    RUN_TEST(floor_and_ceiling);
+    RUN_TEST(probe_comparator_lookups);
+    RUN_TEST(merge_lists);
+    RUN_TEST(split_list);
+#if SKIPLIST_FINGERPRINT
+    RUN_TEST(fingerprint_search);
+#endif
+#if SKIPLIST_STATS
+    RUN_TEST(stats_counters);
+    RUN_TEST(adaptive_height);
+#endif
+    RUN_TEST(cmp_bytes);
+    RUN_TEST(unrolled_add_get_delete);
+    RUN_TEST(unrolled_iter);
+    RUN_TEST(cow_snapshot);
+    RUN_TEST(cow_snapshot_overlap);
+    RUN_TEST(compact_and_map);
+    RUN_TEST(sharded_ops);
+    RUN_TEST(cursor_walk);
+    RUN_TEST(cursor_seek_and_interleave);
+#if SKIPLIST_BACK_POINTERS
+    RUN_TEST(reverse_iter);
+#endif
+    RUN_TEST(pool_churn);
+    RUN_TEST(pool_many_slabs);
+    RUN_TEST(epoch_reclaim);
+    RUN_TEST(concurrent_basic);
     RUN_TEST(first);
     RUN_TEST(last);
     RUN_TEST(clear);
     RUN_TEST(free_clear);
+    RUN_TEST(destructor);
+    RUN_TEST(detach_and_drain);
     RUN_TEST(pop_first);
     RUN_TEST(pop_last);
 }